@@ -16,21 +16,206 @@
 #include <SDL_mixer.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <math.h>
 
+// --- Build profiles ---
+// make PROFILE=handheld|cabinet|tournament selects a SKU at compile
+// time. Capacities are plain #defines so the compiler sizes the static
+// pools exactly and dead-strips whole subsystems; a knob a profile does
+// not pin falls through to the cabinet (stress) default below, and any
+// of them can still be overridden individually with -D on the command
+// line.
+#if defined(PROFILE_HANDHELD)
+// Small static arrays, incremental renderer on by default, and no
+// networking code or buffers in the binary at all.
+#define ASTEROID_CHUNK 256
+#define ASTEROID_HARD_CAP 2048
+#define MAX_PARTICLES 4096
+#define MAX_SIM_WORKERS 2
+#define GRID_CELL_SIZE 40
+#define INCREMENTAL_DEFAULT 1
+#define FEATURE_NET 0
+#elif defined(PROFILE_TOURNAMENT)
+// Fixed classic rules: the field can never grow past a classic-sized
+// cap, so every run is comparable across bracket rigs.
+#define ASTEROID_CHUNK 128
+#define ASTEROID_HARD_CAP 128
+#define MAX_PARTICLES 8192
+#endif
+#ifndef FEATURE_NET
+#define FEATURE_NET 1
+#endif
+#ifndef INCREMENTAL_DEFAULT
+#define INCREMENTAL_DEFAULT 0
+#endif
+
+// Co-op networking is plain UDP sockets; winsock on the Windows SKU.
+// Profiles without FEATURE_NET compile none of it.
+#if FEATURE_NET
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h> // socklen_t on mingw-w64
+typedef SOCKET net_socket_t;
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+typedef int net_socket_t;
+#define INVALID_SOCKET (-1)
+#endif
+#endif // FEATURE_NET
+
 // --- Game Constants ---
-#define SCREEN_WIDTH 800
-#define SCREEN_HEIGHT 600
+// Simulation runs in a fixed world coordinate space; the window can be
+// any size and the renderer applies one uniform scale (plus letterbox
+// offsets) when vertices enter the batch. Wrap constants stay
+// compile-time, so the hot integrate/wrap path has no per-entity
+// divides regardless of output resolution.
+#define WORLD_WIDTH 800
+#define WORLD_HEIGHT 600
+#define DEFAULT_WINDOW_WIDTH 800
+#define DEFAULT_WINDOW_HEIGHT 600
 #define SHIP_SIZE 20.0f
 #define SHIP_ACCELERATION 0.1f
 #define SHIP_TURN_SPEED 5.0f
 #define SHIP_FRICTION 0.995f
 #define BULLET_SPEED 7.0f
 #define MAX_BULLETS 10
-#define MAX_ASTEROIDS 50
+// Asteroid storage grows in large chunks up to a hard budget; when the
+// budget is hit, new spawns recycle the slot of the asteroid farthest
+// from the player instead of silently vanishing.
+#ifndef ASTEROID_CHUNK
+#define ASTEROID_CHUNK 1024
+#endif
+#ifndef ASTEROID_HARD_CAP
+#define ASTEROID_HARD_CAP 65536
+#endif
+#ifndef MAX_PARTICLES
+#define MAX_PARTICLES 32768 // fixed pool, sized for chain-explosion bursts
+#endif
+#define PARTICLE_LIFETIME 40 // ticks
 #define SAMPLE_RATE 44100
-#define RESPAWN_INVINCIBILITY 180 // 3 seconds at 60fps
+#define SOUND_QUEUE_SIZE 256 // power of two; SPSC ring of audio commands
+// Pitch-varied explosion samples: variants are synthesized lazily on
+// the audio thread, keyed by (effect, quantized pitch step), and
+// evicted LRU. 12 slots x <=22 KB of Sint16 keeps the cache under
+// ~256 KB on the cabinet SKU.
+#define SND_BANG_LARGE 0
+#define SND_BANG_MEDIUM 1
+#define SND_BANG_SMALL 2
+#define PITCH_STEPS 8
+#define SAMPLE_CACHE_SLOTS 12
+#define SAMPLE_EVICT_AGE_MS 1000 // fresher buffers may still be feeding the mixer
+#define TELEM_PATH "asteroids.telemetry"
+#define TELEM_MAGIC 0x32545241u // "ART2" little-endian; v2 adds gov_level
+#define TELEM_MAGIC_V1 0x4C545241u // "ARTL", records without gov_level
+#define TELEM_QUEUE_SIZE 64 // power of two; SPSC ring of pending records
+#if FEATURE_NET
+// Two-cabinet co-op: deterministic lockstep, one input byte per tick
+// per player, with an input delay to hide one network round trip. Both
+// cabinets run the identical simulation from a shared seed; the state
+// path below only exists to recover from packet loss.
+#define NET_PORT 47845
+#define NET_INPUT_WINDOW 256 // power of two; per-tick input rings
+#define NET_DELAY_TICKS 3
+#define NET_INPUT_REDUNDANCY 8 // inputs repeated per packet to ride out loss
+#define NET_STALL_RESYNC 30 // stalled frames before the client asks for state
+// Worst-case snapshot blob: every entity pool at its compiled cap
+// (bytes per entity mirror snapshot_save's layout).
+#define NET_BLOB_MAX ((size_t)ASTEROID_HARD_CAP * (9 * sizeof(float) + 4 * sizeof(int) + 1) \
+                    + (size_t)MAX_BULLETS * (6 * sizeof(float) + sizeof(int)) \
+                    + (size_t)MAX_PARTICLES * (6 * sizeof(float) + sizeof(int)))
+// Resync buffers hold that blob plus the scalar meta. The host falls
+// back to a raw blob dump whenever the RLE delta would run larger, so
+// this is a true upper bound, not a hope.
+#define NET_SYNC_MAX (NET_BLOB_MAX + 256)
+#define NET_CHUNK 1200 // resync payload per datagram, under typical MTU
+#endif
+#ifndef MAX_SIM_WORKERS
+#define MAX_SIM_WORKERS 8
+#endif
+#define PARALLEL_MIN_COUNT 512 // below this, fan-out costs more than it saves
+#define SIM_HZ 60 // fixed simulation rate, independent of render rate
+#define FIRE_COOLDOWN_TICKS 12 // 200 ms at SIM_HZ
+#define HEADLESS_SEED 12345 // fixed srand seed so benchmark runs are repeatable
+#define REPLAY_MAGIC 0x59505241u // "ARPY"
+#define REPLAY_VERSION 1
+
+// Incremental rendering (handheld builds): the scene persists in a
+// target texture; each frame erases only last frame's entity bounding
+// boxes and redraws, falling back to a full clear when the dirty area
+// passes this fraction of the screen (in 1/256ths).
+#define DIRTY_AREA_THRESHOLD_256 128 // fall back at >50% of screen area
+
+// Instrumentation phases. Timers cost one SDL_GetPerformanceCounter
+// pair per phase, cheap enough to stay enabled in shipping builds.
+#define PROF_INPUT 0
+#define PROF_INTEGRATE 1
+#define PROF_COLLIDE 2
+#define PROF_SPAWN 3
+#define PROF_RENDER 4
+#define PROF_PRESENT 5 // the vsync block inside SDL_RenderPresent
+#define PROF_FRAME 6
+#define PROF_PHASES 7
+#define PROF_BUCKETS 32 // log2(us) histogram buckets
+#define PROF_CSV_PATH "profile.csv"
+
+// Adaptive quality governor: the same binary runs on everything from a
+// 1.2 GHz handheld SoC to a 16-core cabinet, so degradable knobs
+// (particle spawn rate, asteroid outline LOD, rotated-cache refresh
+// granularity, dirty-rect vs full clear) are stepped up or down to
+// hold the rolling p99 of per-frame work time -- the frame minus its
+// vsync block, which would otherwise pin the measurement at the
+// refresh period on any display that is keeping up. Decisions happen once
+// per window, move one level at a time, and quality only comes back
+// after consecutive calm windows -- the gap between the raise and
+// relax thresholds is the hysteresis band.
+#define GOV_WINDOW_FRAMES 120 // ~2 s at 60 fps per decision
+#define GOV_TARGET_P99_US 15000 // degrade above this (work nearly fills a 60 Hz frame)
+#define GOV_RELAX_P99_US 9000 // re-raise quality only below this
+#define GOV_RELAX_WINDOWS 2 // ...and only after this many calm windows
+#define GOV_MAX_LEVEL 3
+
+// Input bitmask shared by every input provider (keyboard, benchmark script)
+#define INPUT_LEFT   0x1u
+#define INPUT_RIGHT  0x2u
+#define INPUT_THRUST 0x4u
+#define INPUT_FIRE   0x8u
+// Autoplay (attract mode): the AI re-picks its target only every
+// AI_RETARGET_TICKS via an expanding-ring walk over the spatial grid,
+// capped at AI_MAX_RING rings, so its per-tick cost is a handful of
+// cell visits plus some trig -- bounded regardless of entity count.
+#define AI_RETARGET_TICKS 8
+#define AI_MAX_RING 8
+#define AI_AIM_TOLERANCE 6.0f // degrees; fire window is twice this
+#define AI_DANGER_RADIUS 110.0f
+#define RESPAWN_INVINCIBILITY 180 // 3 seconds at 60 ticks/sec
+// Largest radius spawn_asteroid() can generate: size 3 * (8 + 4) px.
+// Grid queries pad their cell range by this much.
+#define ASTEROID_MAX_RADIUS 36.0f
+// Broad-phase collision grid. Cell size is on the order of a large
+// asteroid's radius, so any circle test only ever needs to look at the
+// cells overlapping the query box instead of every asteroid.
+#ifndef GRID_CELL_SIZE
+#define GRID_CELL_SIZE 30
+#endif
+#define GRID_COLS ((WORLD_WIDTH + GRID_CELL_SIZE - 1) / GRID_CELL_SIZE)
+#define GRID_ROWS ((WORLD_HEIGHT + GRID_CELL_SIZE - 1) / GRID_CELL_SIZE)
+// Shape bank: polygon outlines are pregenerated per size class at
+// startup and referenced by index, so spawning an asteroid is a
+// constant-time index pick with no trig, and instances share vertex
+// data instead of each carrying a 128-byte copy.
+#define SHAPES_PER_SIZE 128
+#define SHAPE_MAX_VERTICES 16
+
+// Quantized rotation: asteroid angles are snapped to ROT_STEPS discrete
+// steps for rendering, served from a sin/cos lookup table. Must be a
+// power of two so negative angles mask cleanly.
+#define ROT_STEPS 1024
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -38,29 +223,28 @@
 // --- Structs ---
 typedef struct {
     float x, y;
+    float prev_x, prev_y; // position at the previous tick, for render interpolation
     float vx, vy;
     float angle;
     int alive;
     int invincible_timer;
 } Ship;
 
+// A bullet kill queues split events instead of spawning mid-pass, so
+// the collision loop never mutates the asteroid array it is walking and
+// the vertex-generation cost lands in one batch after resolution. Each
+// bullet can kill at most one asteroid per tick, so the queue bound is
+// two children per possible kill.
+#define MAX_SPLIT_EVENTS (MAX_BULLETS * 2)
 typedef struct {
     float x, y;
-    float vx, vy;
-    float angle;
-    float rotation_speed;
-    int size; // 3=large, 2=medium, 1=small
-    int num_vertices;
-    float vertices[32]; // Increased size to prevent buffer overflow (was 16)
-    int alive;
-} Asteroid;
+    int size;
+} SplitEvent;
 
-typedef struct {
-    float x, y;
-    float vx, vy;
-    int lifetime;
-    int active;
-} Bullet;
+// Entity storage is structure-of-arrays: the integration loop streams
+// through the hot position/velocity arrays without dragging the cold
+// per-asteroid vertex data through cache. Live entities are kept dense
+// in [0, count); despawns swap the last entry into the freed slot.
 
 // --- Global Variables ---
 SDL_Window* g_window = NULL;
@@ -71,350 +255,2864 @@ Mix_Chunk* g_bang_large_sound = NULL;
 Mix_Chunk* g_bang_medium_sound = NULL;
 Mix_Chunk* g_bang_small_sound = NULL;
 
+// Audio runs off the game thread: synthesis happens on a one-shot worker
+// at startup (chunks hot-swap in as each finishes), and play/halt
+// requests go through a lock-free single-producer ring drained by a
+// dedicated audio thread. The simulation tick never touches the mixer.
+typedef struct {
+    Mix_Chunk* chunk;
+    int channel;
+    int loops;
+    int halt; // 1 = halt `channel` instead of playing
+    int effect; // >= 0: play a cached pitch variant instead of `chunk`
+    int pitch; // quantized step, 0..PITCH_STEPS-1
+    int volume; // 0..MIX_MAX_VOLUME, or -1 for the chunk default
+} SoundCommand;
+
+// One cached pitch variant. Only the audio thread touches the cache,
+// so it needs no locking; an empty slot has chunk == NULL.
+typedef struct {
+    int effect;
+    int pitch;
+    Mix_Chunk* chunk;
+    Sint16* data;
+    Uint32 last_used; // SDL_GetTicks at last play, for LRU eviction
+} SampleVariant;
+
+SoundCommand g_sound_queue[SOUND_QUEUE_SIZE];
+SDL_atomic_t g_sound_queue_head; // consumer cursor (audio thread)
+SDL_atomic_t g_sound_queue_tail; // producer cursor (game thread)
+SDL_atomic_t g_audio_quit;
+SDL_sem* g_sound_sem = NULL;
+SDL_Thread* g_audio_thread = NULL;
+SDL_Thread* g_synth_thread = NULL;
+int g_thrust_playing = 0; // producer-side notion of channel 1 state
+SampleVariant g_sample_cache[SAMPLE_CACHE_SLOTS];
+
+// Per-tick kill coalescer. A chain-explosion tick can destroy 100+
+// asteroids; playing each one would flood the ring and the mixer's 8
+// channels would silently drop most of them anyway. Kills are tallied
+// per size class during the collision pass and collapsed into at most
+// one play command per class at end of tick, with volume scaled by the
+// kill count so a mass detonation still reads louder than a single pop.
+int g_kill_count[3]; // kills this tick, indexed by SND_BANG_*
+int g_kill_pitch[3]; // pitch step of the first kill in each class
+
+// Persistent high-score / telemetry store: fixed-size records appended
+// to a small binary log. Records go through a lock-free SPSC ring (same
+// shape as the sound queue) and are written by a dedicated thread with
+// plain buffered stdio -- never fsync, and never any file I/O on the
+// game thread, because cabinet SD cards stall for 50 ms+ on writes.
+// Records are queued at level boundaries and at session end.
+typedef struct {
+    Uint32 magic;          // TELEM_MAGIC
+    Uint32 score;
+    Uint32 level;
+    Uint32 ticks;          // ticks simulated so far this session
+    Uint32 peak_asteroids;
+    Uint32 frame_p50_us;   // from the profiler's log2 histograms
+    Uint32 frame_p99_us;
+    Uint32 end_of_session; // 1 on the final record of a session
+    Uint32 gov_level;      // quality level the governor had settled on
+} TelemetryRecord;
+
+TelemetryRecord g_telem_queue[TELEM_QUEUE_SIZE];
+SDL_atomic_t g_telem_queue_head; // consumer cursor (telemetry thread)
+SDL_atomic_t g_telem_queue_tail; // producer cursor (game thread)
+SDL_atomic_t g_telem_quit;
+SDL_sem* g_telem_sem = NULL;
+SDL_Thread* g_telem_thread = NULL;
+int g_high_score = 0; // best score in the log at startup, tracks live play
+Uint32 g_session_ticks = 0;
+Uint32 g_session_peak_asteroids = 0;
+
+// Governor state: a per-window frame-time histogram (same log2 bucket
+// scheme as the profiler) plus the current level and the knob values
+// derived from it. Level 0 is full quality.
+Uint32 g_gov_hist[PROF_BUCKETS];
+int g_gov_frames = 0;
+int g_gov_level = 0;
+int g_gov_calm_windows = 0; // consecutive windows below the relax threshold
+int g_gov_particle_shift = 0; // spawn counts are right-shifted by this
+int g_gov_lod = 0; // 1: small asteroids drop every other outline vertex
+int g_gov_rot_coarse = 0; // extra rot-step quantization, fewer cache refreshes
+int g_gov_dirty_threshold_256 = DIRTY_AREA_THRESHOLD_256;
+
+// Simulation job system: a pool of workers runs one function over
+// disjoint entity ranges (fork-join, one job kind in flight at a time).
+// The main thread takes the tail range itself, then waits for the pool.
+// Collision resolution stays serial; only the embarrassingly parallel
+// passes (integration, grid binning) fan out.
+typedef void (*JobFunc)(int start, int end);
+SDL_Thread* g_sim_workers[MAX_SIM_WORKERS];
+int g_sim_worker_count = 0;
+JobFunc g_job_func = NULL;
+int g_job_begin[MAX_SIM_WORKERS];
+int g_job_end[MAX_SIM_WORKERS];
+SDL_sem* g_job_go[MAX_SIM_WORKERS];
+SDL_sem* g_job_done = NULL;
+SDL_atomic_t g_workers_quit;
+
 Ship g_ship;
-Bullet g_bullets[MAX_BULLETS];
-Asteroid g_asteroids[MAX_ASTEROIDS];
+
+// Bullets (SoA, dense)
+int g_bullet_count = 0;
+float g_bullet_x[MAX_BULLETS];
+float g_bullet_y[MAX_BULLETS];
+float g_bullet_prev_x[MAX_BULLETS];
+float g_bullet_prev_y[MAX_BULLETS];
+float g_bullet_vx[MAX_BULLETS];
+float g_bullet_vy[MAX_BULLETS];
+int g_bullet_lifetime[MAX_BULLETS];
+
+// Asteroids (SoA, dense). Hot integration data first, cold shape data
+// last. The arrays are arena-style: allocated in ASTEROID_CHUNK-sized
+// steps (no per-entity malloc), never shrunk, capped at
+// ASTEROID_HARD_CAP. Nothing holds asteroid indices across ticks, so
+// dense indices stay valid without generation-checked handles.
+int g_asteroid_count = 0;
+int g_asteroid_capacity = 0;
+float* g_asteroid_x = NULL;
+float* g_asteroid_y = NULL;
+float* g_asteroid_prev_x = NULL;
+float* g_asteroid_prev_y = NULL;
+float* g_asteroid_vx = NULL;
+float* g_asteroid_vy = NULL;
+float* g_asteroid_angle = NULL;
+float* g_asteroid_rot_speed = NULL;
+int* g_asteroid_size = NULL; // 3=large, 2=medium, 1=small
+float* g_asteroid_radius = NULL; // true max vertex distance, from the shape bank
+int* g_asteroid_dead = NULL; // marked during collision, compacted end of tick
+int* g_asteroid_shape = NULL; // index into the shape bank for this size class
+// Rotated copies of the shape-bank vertices, recomputed only when the
+// quantized angle actually changes (rot_step caches the last step used,
+// -1 = dirty).
+int* g_asteroid_rot_step = NULL;
+float (*g_asteroid_rotated)[SHAPE_MAX_VERTICES * 2] = NULL;
+// Visibility byte, refreshed during integration: wrapped position
+// tested against the view rect grown by the max asteroid radius. The
+// renderer and the rotated-vertex cache skip invisible entries, so an
+// off-screen rock costs nothing beyond integration.
+Uint8* g_asteroid_visible = NULL;
+
+// The shape bank itself, indexed [size - 1][shape]. Vertices are x/y
+// interleaved model-space coordinates.
+float g_shape_vertices[3][SHAPES_PER_SIZE][SHAPE_MAX_VERTICES * 2];
+int g_shape_num_vertices[3][SHAPES_PER_SIZE];
+float g_shape_radius[3][SHAPES_PER_SIZE];
+
+float g_sin_table[ROT_STEPS];
+float g_cos_table[ROT_STEPS];
+
+// Particles (SoA, dense, fixed pool -- no per-particle allocation).
+// Spawns beyond the pool cap are dropped rather than resized.
+int g_particle_count = 0;
+float g_particle_x[MAX_PARTICLES];
+float g_particle_y[MAX_PARTICLES];
+float g_particle_prev_x[MAX_PARTICLES];
+float g_particle_prev_y[MAX_PARTICLES];
+float g_particle_vx[MAX_PARTICLES];
+float g_particle_vy[MAX_PARTICLES];
+int g_particle_life[MAX_PARTICLES];
+
+SplitEvent g_split_queue[MAX_SPLIT_EVENTS];
+int g_split_count = 0;
 
 int g_score = 0;
 int g_lives = 3;
 int g_level = 1;
 int g_game_over = 0;
+int g_headless = 0; // --headless N: simulate without window/renderer/audio
+int g_resim_ticks = 0; // --resim M: re-run the final headless tick M times
+int g_fire_cooldown = 0; // ticks until the ship may fire again
+Ship g_ship2; // player 2, only alive in co-op
+int g_fire_cooldown2 = 0;
+int g_autoplay = 0; // --autoplay / F3: AI pilots the ship (attract mode)
+int g_ai_target = -1; // asteroid index, revalidated every retarget
+int g_ai_retarget = 0; // ticks until the next grid search
+
+// Replay: the whole session is reproducible from the RNG seed plus one
+// input byte per tick (4 bits used), so an hour of play is ~211 KB.
+// Recording streams through stdio's buffer; playback loads the file up
+// front and feeds ticks from memory.
+FILE* g_record_file = NULL;
+const char* g_record_path = NULL;
+const char* g_replay_path = NULL;
+Uint8* g_replay_inputs = NULL;
+int g_replay_length = 0;
+int g_replay_pos = 0;
+unsigned g_rng_seed = 0; // seed this session actually ran with
+
+// Game-state snapshot: progress scalars plus the live prefix of every
+// entity array, memcpy'd into one preallocated blob. The rotated-vertex
+// cache and grid are skipped -- both are rebuilt on demand -- so a
+// save or restore is a handful of straight memcpys, fast enough to run
+// thousands of times in the benchmark harness. rand() state is not
+// captured; restored play diverges from the original timeline, which
+// is fine for save-states and irrelevant for perf re-runs.
+typedef struct {
+    int valid;
+    Uint8* blob;
+    size_t blob_capacity;
+    int asteroid_count;
+    int bullet_count;
+    int particle_count;
+    Ship ship;
+    Ship ship2;
+    int score, lives, level, game_over, fire_cooldown, fire_cooldown2;
+    size_t blob_len;
+} GameSnapshot;
+GameSnapshot g_snapshot;
+
+// Network state. Host simulates player 1, client player 2. All buffers
+// are preallocated at net_init(); nothing on the per-tick network path
+// allocates, so a heap hiccup can never show up as input latency.
+// g_net_mode stays defined in every profile (the simulation checks it
+// for ship 2); without FEATURE_NET it can never leave zero.
+int g_net_mode = 0; // 0 = local, 1 = host, 2 = client
+#if FEATURE_NET
+net_socket_t g_net_sock = INVALID_SOCKET;
+struct sockaddr_in g_net_peer;
+int g_net_have_peer = 0;
+Uint32 g_net_tick = 0; // next simulation tick to run in lockstep
+Uint32 g_net_local_next = 0; // next tick we still need to sample input for
+Uint8 g_net_local_inputs[NET_INPUT_WINDOW];
+Uint8 g_net_remote_inputs[NET_INPUT_WINDOW];
+Uint8 g_net_remote_have[NET_INPUT_WINDOW];
+int g_net_stall_frames = 0;
+Uint8* g_net_base_blob = NULL; // last acked snapshot, the delta baseline
+size_t g_net_base_len = 0;
+Uint8* g_net_sync_buf = NULL; // host: outgoing image; client: reassembly
+size_t g_net_sync_total = 0;
+size_t g_net_sync_got = 0;
+Uint32 g_net_sync_id = 0;
+Uint8 g_net_sync_have[NET_SYNC_MAX / NET_CHUNK + 1]; // one flag per chunk
+const char* g_net_join_addr = NULL;
+#endif // FEATURE_NET
+
+// Profiler state: per phase a running sum/max/count plus a log2
+// microsecond histogram, so p99s survive arbitrarily long sessions in
+// constant memory. Dumped as CSV at exit; the in-game overlay (F1)
+// shows the most recent sample per phase.
+Uint64 g_perf_freq = 0;
+Uint64 g_prof_sum[PROF_PHASES];
+Uint64 g_prof_max[PROF_PHASES];
+Uint64 g_prof_samples[PROF_PHASES];
+Uint32 g_prof_hist[PROF_PHASES][PROF_BUCKETS];
+Uint64 g_prof_last_us[PROF_PHASES];
+Uint64 g_present_start = 0; // set by render_game just before the present
+int g_show_profiler = 0; // toggled with F1
+
+// World-to-screen transform, recomputed on window resize. Applied once
+// per vertex as it enters the batch; simulation never sees screen space.
+int g_window_w = DEFAULT_WINDOW_WIDTH;
+int g_window_h = DEFAULT_WINDOW_HEIGHT;
+float g_render_scale = 1.0f;
+float g_render_off_x = 0.0f;
+float g_render_off_y = 0.0f;
+// View rect in world coordinates. The default view is the whole world,
+// so on stock builds everything classifies visible and culling costs
+// four compares per asteroid; zoomed or large-world configurations
+// narrow this rect and reap the skips.
+float g_view_min_x = 0.0f;
+float g_view_min_y = 0.0f;
+float g_view_max_x = (float)WORLD_WIDTH;
+float g_view_max_y = (float)WORLD_HEIGHT;
+
+// Transform the batch actually applies this frame (identity when
+// drawing into the world-resolution scene texture).
+float g_batch_scale = 1.0f;
+float g_batch_off_x = 0.0f;
+float g_batch_off_y = 0.0f;
+
+// Dirty-rect state: boxes drawn last frame (to erase) and this frame.
+// The two lists swap each frame.
+int g_incremental_mode = INCREMENTAL_DEFAULT; // --incremental, or F2 at runtime
+int g_incremental_valid = 0; // scene texture holds last frame's pixels
+SDL_Texture* g_scene_texture = NULL;
+// Cached HUD layer: the ten digits plus the lives ship icon are
+// rendered once at startup into a glyph atlas, and score / high score
+// / lives are composed as textured quads over it. The quad batch is
+// rebuilt only when a shown value (or the batch transform) changes, so
+// the steady-state HUD costs one SDL_RenderGeometry call and zero
+// formatting. Cells are 22 px wide -- the 17 px glyph plus transparent
+// padding -- while the on-screen digit advance stays 16 px.
+#define HUD_CELL_W 22
+#define HUD_CELL_H 40
+#define HUD_GLYPH_SHIP 10
+#define HUD_ATLAS_CELLS 11
+#define HUD_MAX_QUADS 64
+SDL_Texture* g_hud_atlas = NULL;
+SDL_Vertex g_hud_vertices[HUD_MAX_QUADS * 4];
+int g_hud_indices[HUD_MAX_QUADS * 6];
+int g_hud_quads = 0;
+int g_hud_score = -1, g_hud_high = -1, g_hud_lives = -1; // composed values
+float g_hud_scale = 0.0f, g_hud_off_x = 0.0f, g_hud_off_y = 0.0f;
+SDL_Rect* g_dirty_prev = NULL;
+SDL_Rect* g_dirty_cur = NULL;
+int g_dirty_prev_count = 0;
+int g_dirty_cur_count = 0;
+int g_dirty_capacity = 0;
+
+// Spatial hash grid: per-cell singly linked lists of asteroid indices,
+// rebuilt once per tick. -1 terminates a list. Cell classification is
+// computed in parallel into g_asteroid_cell; the list-link pass is a
+// cheap serial sweep.
+int g_grid_head[GRID_COLS * GRID_ROWS];
+int* g_grid_next = NULL;
+int* g_asteroid_cell = NULL;
+
+// Batched geometry renderer: every line, point and rect drawn in a frame
+// is appended to one growable vertex/index buffer (lines become thin
+// quads) and submitted in a single SDL_RenderGeometry call, instead of
+// one SDL draw call per primitive.
+SDL_Vertex* g_batch_vertices = NULL;
+int* g_batch_indices = NULL;
+int g_batch_vertex_count = 0;
+int g_batch_vertex_capacity = 0;
+int g_batch_index_count = 0;
+int g_batch_index_capacity = 0;
+
+// Render-prep pipeline: the per-asteroid outline transform (the most
+// expensive part of a frame at high entity counts) is built into a
+// dedicated vertex/index buffer by the worker pool while the main
+// thread draws everything else. A serial prefix pass assigns each
+// asteroid its exact slot, so workers write disjoint compact ranges
+// and the result submits as one SDL_RenderGeometry call with no
+// gather step. Buffers are double-buffered on frame parity.
+SDL_Vertex* g_prep_vertices[2] = {NULL, NULL};
+int* g_prep_indices[2] = {NULL, NULL};
+int g_prep_capacity = 0; // in asteroids
+int* g_prep_voffset = NULL; // per-asteroid vertex base (prefix sums)
+int* g_prep_ioffset = NULL; // per-asteroid index base
+int g_prep_buf = 0;
+int g_prep_count = 0; // asteroids captured at kick time
+int g_prep_total_vertices = 0;
+int g_prep_total_indices = 0;
+float g_prep_alpha = 0.0f;
+int g_prep_async = 0; // worker fan-outs outstanding
 
 // --- Function Prototypes ---
 int initialize();
 void create_sounds();
+int sound_synthesis_thread(void* data);
+int audio_thread_main(void* data);
+void queue_sound(Mix_Chunk* chunk, int channel, int loops);
+void queue_sound_pitched(int effect, int pitch, int volume);
+void record_kill(int effect, int pitch);
+void flush_kill_sounds();
+void queue_halt(int channel);
+float synth_sine(double phase);
+Mix_Chunk* sample_cache_get(int effect, int pitch);
+int telemetry_thread_main(void* data);
+void telemetry_load_high_score();
+void queue_telemetry(int end_of_session);
 void setup_level();
 void spawn_asteroid(float x, float y, int size);
+void grow_asteroid_storage();
+void compact_asteroids();
+void spawn_particles(float x, float y, int count, float max_speed);
+void update_particles();
 void handle_input(int* is_running);
+unsigned read_keyboard_input();
+unsigned autoplay_input();
+unsigned next_tick_input(unsigned live_input);
+void apply_ship_controls(unsigned input);
+void reset_game();
+void snapshot_save();
+void snapshot_restore();
+void apply_controls(Ship* ship, int* cooldown, unsigned input, int local_sound);
+void fire_bullet(Ship* ship);
+void update_ship(Ship* ship);
+void ship_asteroid_collision(Ship* ship);
+void draw_ship(const Ship* ship, float alpha, int incremental);
+#if FEATURE_NET
+int net_init();
+void net_pump();
+int net_tick_ready(unsigned local_input);
+size_t net_encode_delta(const Uint8* cur, size_t cur_len,
+                        const Uint8* base, size_t base_len,
+                        Uint8* out, size_t max_out);
+void net_apply_delta(Uint8* cur, size_t cur_len,
+                     const Uint8* base, size_t base_len,
+                     const Uint8* delta, size_t delta_len);
+void net_send_resync();
+void net_apply_resync();
+void net_shutdown();
+#endif
 void update_game();
+int run_headless(int ticks);
+void run_parallel(JobFunc fn, int count);
+void run_parallel_async(JobFunc fn, int count);
+void run_parallel_wait();
+void render_prep_kick(float alpha);
+void render_prep_finish();
+void job_prep_asteroids(int start, int end);
+void prof_record(int phase, Uint64 elapsed_ticks);
+void prof_dump_csv();
+void gov_apply();
+void gov_frame(Uint64 frame_us);
+int prep_outline_step(int i, int n);
+void job_integrate_asteroids(int start, int end);
+void job_integrate_particles(int start, int end);
+void job_bin_asteroids(int start, int end);
+int point_in_asteroid(int i, float px, float py);
+int sweep_circle(float px, float py, float dx, float dy, float r, float* t_in, float* t_out);
+void grid_rebuild();
+int grid_cell_range(float x, float y, float radius, int* min_col, int* max_col, int* min_row, int* max_row);
 void wrap_coordinates(float* x, float* y);
-void render_game();
+void integrate_and_wrap(int count, float* restrict x, float* restrict y,
+                        const float* restrict vx, const float* restrict vy);
+float lerp_wrapped(float prev, float cur, float alpha, float span);
+void render_game(float alpha);
+void batch_add_line(float x1, float y1, float x2, float y2);
+void batch_add_point(float x, float y);
+void batch_add_rect(float x, float y, float w, float h);
+void batch_flush();
+void dirty_add(float x, float y, float w, float h);
+void update_render_scale();
 void cleanup();
 void draw_digit(int digit, int x, int y);
 void draw_number(int number, int x, int y);
+void hud_atlas_init();
+void hud_add_glyph(int cell, float x, float y);
+void hud_add_number(int number, float x, float y);
+void hud_draw();
 
 // --- Main ---
 int main(int argc, char* argv[]) {
+    int headless_ticks = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0 && i + 1 < argc) {
+            g_headless = 1;
+            headless_ticks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--resim") == 0 && i + 1 < argc) {
+            g_resim_ticks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--incremental") == 0) {
+            g_incremental_mode = 1;
+        } else if (strcmp(argv[i], "--autoplay") == 0) {
+            g_autoplay = 1;
+#if FEATURE_NET
+        } else if (strcmp(argv[i], "--host") == 0) {
+            g_net_mode = 1;
+        } else if (strcmp(argv[i], "--join") == 0 && i + 1 < argc) {
+            g_net_mode = 2;
+            g_net_join_addr = argv[++i];
+#endif
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            g_record_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            g_replay_path = argv[++i];
+        }
+    }
+
     if (!initialize()) {
         cleanup();
         return 1;
     }
-    g_score = 0;
-    g_lives = 3;
-    g_level = 1;
-    g_game_over = 0;
+    reset_game();
+#if FEATURE_NET
+    if (g_net_mode) {
+        // Both sides capture the identical starting state as the first
+        // delta baseline.
+        snapshot_save();
+        memcpy(g_net_base_blob, g_snapshot.blob, g_snapshot.blob_len);
+        g_net_base_len = g_snapshot.blob_len;
+    }
+#endif
+
+    if (g_headless) {
+        // A replay defines its own length; benchmark exactly that session.
+        if (g_replay_inputs) headless_ticks = g_replay_length;
+        int rc = run_headless(headless_ticks);
+        cleanup();
+        return rc;
+    }
 
-    setup_level();
     int is_running = 1;
-    while (is_running && !g_game_over) {
+
+    // Fixed-timestep loop: simulation always advances in 1/SIM_HZ steps,
+    // the renderer runs as fast as the display allows and interpolates
+    // between the last two simulation states. A stall longer than the
+    // accumulator clamp drops ticks instead of spiralling.
+    const double dt = 1.0 / SIM_HZ;
+    Uint64 perf_freq = SDL_GetPerformanceFrequency();
+    Uint64 prev_counter = SDL_GetPerformanceCounter();
+    double accumulator = 0.0;
+    // Game over freezes the simulation (the tick loop below skips) but
+    // keeps rendering; Return restarts in-process via reset_game().
+    while (is_running) {
+        Uint64 now = SDL_GetPerformanceCounter();
+        accumulator += (double)(now - prev_counter) / (double)perf_freq;
+        prev_counter = now;
+        if (accumulator > 0.25) accumulator = 0.25;
+
+        Uint64 frame_start = SDL_GetPerformanceCounter();
+        Uint64 t0 = frame_start;
         handle_input(&is_running);
-        update_game();
-        render_game();
-        SDL_Delay(16);
+        prof_record(PROF_INPUT, SDL_GetPerformanceCounter() - t0);
+#if FEATURE_NET
+        if (g_net_mode) net_pump();
+#endif
+        while (accumulator >= dt && !g_game_over) {
+#if FEATURE_NET
+            if (g_net_mode) {
+                // Lockstep: the tick only runs once the remote input
+                // byte for it has arrived; otherwise drop the time and
+                // let the resync path recover if the gap persists.
+                net_pump();
+                if (!net_tick_ready(read_keyboard_input())) {
+                    accumulator = 0.0;
+                    break;
+                }
+                unsigned p1 = g_net_remote_inputs[g_net_tick & (NET_INPUT_WINDOW - 1)];
+                unsigned p2 = g_net_local_inputs[g_net_tick & (NET_INPUT_WINDOW - 1)];
+                if (g_net_mode == 1) { unsigned t = p1; p1 = p2; p2 = t; } // host drives ship 1
+                apply_ship_controls(p1);
+                apply_controls(&g_ship2, &g_fire_cooldown2, p2, g_net_mode == 2);
+                g_net_remote_have[g_net_tick & (NET_INPUT_WINDOW - 1)] = 0;
+                g_net_tick++;
+                update_game();
+                accumulator -= dt;
+                continue;
+            }
+#endif
+            // The AI is just another live-input provider: its byte goes
+            // through next_tick_input() like the keyboard's, so record
+            // and replay capture autoplay sessions identically.
+            unsigned live = g_autoplay ? autoplay_input() : read_keyboard_input();
+            apply_ship_controls(next_tick_input(live));
+            update_game();
+            accumulator -= dt;
+        }
+        t0 = SDL_GetPerformanceCounter();
+        // While the simulation is frozen (game over, lockstep stall)
+        // the accumulator can pin at its clamp; alpha past 1 would
+        // extrapolate every entity well beyond its true position.
+        float alpha = (float)(accumulator / dt);
+        if (alpha > 1.0f) alpha = 1.0f;
+        render_game(alpha);
+        Uint64 render_end = SDL_GetPerformanceCounter();
+        prof_record(PROF_RENDER, g_present_start - t0);
+        prof_record(PROF_PRESENT, render_end - g_present_start);
+        prof_record(PROF_FRAME, render_end - frame_start);
+        // The governor regulates the frame's *work* time. The full
+        // frame time is pinned at the refresh period by vsync on any
+        // display that is keeping up, which would read as permanently
+        // over target on exactly the hardware that is fine.
+        Uint64 work_us = g_perf_freq
+            ? (g_present_start - frame_start) * 1000000u / g_perf_freq : 0;
+        gov_frame(work_us);
     }
     cleanup();
     return 0;
 }
 
 // --- Implementations ---
+void prof_record(int phase, Uint64 elapsed_ticks) {
+    Uint64 us = g_perf_freq ? elapsed_ticks * 1000000u / g_perf_freq : 0;
+    g_prof_last_us[phase] = us;
+    g_prof_sum[phase] += us;
+    if (us > g_prof_max[phase]) g_prof_max[phase] = us;
+    g_prof_samples[phase]++;
+    int bucket = 0;
+    Uint64 v = us;
+    while (v > 1 && bucket < PROF_BUCKETS - 1) { v >>= 1; bucket++; }
+    g_prof_hist[phase][bucket]++;
+}
+
+// Estimates a percentile from the log2 histogram (upper bucket bound, so
+// the estimate errs pessimistic).
+Uint64 prof_percentile_us(int phase, double pct) {
+    Uint64 total = g_prof_samples[phase];
+    if (total == 0) return 0;
+    Uint64 threshold = (Uint64)(total * pct);
+    Uint64 seen = 0;
+    for (int b = 0; b < PROF_BUCKETS; b++) {
+        seen += g_prof_hist[phase][b];
+        if (seen >= threshold) return (Uint64)1 << (b + 1);
+    }
+    return g_prof_max[phase];
+}
+
+void prof_dump_csv() {
+    static const char* names[PROF_PHASES] = {
+        "input", "integrate", "collide", "spawn", "render", "present", "frame"
+    };
+    if (g_prof_samples[PROF_FRAME] == 0 && g_prof_samples[PROF_INTEGRATE] == 0) return;
+    FILE* f = fopen(PROF_CSV_PATH, "w");
+    if (!f) return;
+    fprintf(f, "phase,samples,mean_us,p99_us,max_us\n");
+    for (int p = 0; p < PROF_PHASES; p++) {
+        if (g_prof_samples[p] == 0) continue;
+        fprintf(f, "%s,%llu,%.1f,%llu,%llu\n", names[p],
+                (unsigned long long)g_prof_samples[p],
+                (double)g_prof_sum[p] / g_prof_samples[p],
+                (unsigned long long)prof_percentile_us(p, 0.99),
+                (unsigned long long)g_prof_max[p]);
+    }
+    fclose(f);
+}
+
+// Maps the governor level onto the concrete knobs. Each level sheds a
+// little more: first the particle flood and per-rect erases, then
+// outline detail and rotation refresh rate.
+void gov_apply() {
+    g_gov_particle_shift = g_gov_level >= 3 ? 2 : (g_gov_level >= 1 ? 1 : 0);
+    g_gov_lod = g_gov_level >= 2;
+    g_gov_rot_coarse = g_gov_level >= 3 ? 2 : (g_gov_level >= 2 ? 1 : 0);
+    // Degraded levels skip the per-rect erase pass entirely (threshold
+    // 0 forces the single full clear); the dirty boxes still feed the
+    // next frame's bookkeeping so the knob can move back freely.
+    g_gov_dirty_threshold_256 = g_gov_level >= 2 ? 0 : DIRTY_AREA_THRESHOLD_256;
+}
+
+// One work-time sample (the frame minus its vsync block) into the
+// rolling window; every GOV_WINDOW_FRAMES samples, estimate the
+// window's p99 (same
+// pessimistic log2 upper-bound read as prof_percentile_us) and move
+// the level at most one step. Changes are logged to the telemetry
+// store so field data shows which level each device class settles on.
+void gov_frame(Uint64 frame_us) {
+    int bucket = 0;
+    Uint64 v = frame_us;
+    while (v > 1 && bucket < PROF_BUCKETS - 1) { v >>= 1; bucket++; }
+    g_gov_hist[bucket]++;
+    if (++g_gov_frames < GOV_WINDOW_FRAMES) return;
+    Uint64 threshold = (Uint64)(g_gov_frames * 0.99);
+    Uint64 seen = 0, p99 = (Uint64)1 << PROF_BUCKETS;
+    for (int b = 0; b < PROF_BUCKETS; b++) {
+        seen += g_gov_hist[b];
+        if (seen >= threshold) { p99 = (Uint64)1 << (b + 1); break; }
+    }
+    memset(g_gov_hist, 0, sizeof(g_gov_hist));
+    g_gov_frames = 0;
+    int old_level = g_gov_level;
+    if (p99 > GOV_TARGET_P99_US) {
+        if (g_gov_level < GOV_MAX_LEVEL) g_gov_level++;
+        g_gov_calm_windows = 0;
+    } else if (p99 < GOV_RELAX_P99_US) {
+        if (++g_gov_calm_windows >= GOV_RELAX_WINDOWS && g_gov_level > 0) {
+            g_gov_level--;
+            g_gov_calm_windows = 0;
+        }
+    } else {
+        g_gov_calm_windows = 0; // inside the hysteresis band: hold
+    }
+    if (g_gov_level != old_level) {
+        gov_apply();
+        queue_telemetry(0);
+    }
+}
+
+// Loads a replay into memory. Returns 1 and fills *seed on success.
+int replay_load(const char* path, unsigned* seed) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "replay: cannot open %s\n", path);
+        return 0;
+    }
+    Uint32 header[3];
+    if (fread(header, sizeof(header), 1, f) != 1 ||
+        header[0] != REPLAY_MAGIC || header[1] != REPLAY_VERSION) {
+        fprintf(stderr, "replay: %s is not a valid replay file\n", path);
+        fclose(f);
+        return 0;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f) - (long)sizeof(header);
+    fseek(f, sizeof(header), SEEK_SET);
+    if (size < 0) size = 0;
+    g_replay_inputs = malloc(size ? (size_t)size : 1);
+    g_replay_length = (int)fread(g_replay_inputs, 1, (size_t)size, f);
+    g_replay_pos = 0;
+    fclose(f);
+    *seed = header[2];
+    return 1;
+}
+
+int replay_begin_record(const char* path, unsigned seed) {
+    g_record_file = fopen(path, "wb");
+    if (!g_record_file) {
+        fprintf(stderr, "record: cannot open %s\n", path);
+        return 0;
+    }
+    Uint32 header[3] = {REPLAY_MAGIC, REPLAY_VERSION, (Uint32)seed};
+    fwrite(header, sizeof(header), 1, g_record_file);
+    return 1;
+}
+
+// Resolves the input for one tick: replay bytes override live input, and
+// whatever actually drove the tick is appended to the recording.
+unsigned next_tick_input(unsigned live_input) {
+    unsigned input = live_input;
+    if (g_replay_inputs) {
+        input = (g_replay_pos < g_replay_length) ? g_replay_inputs[g_replay_pos++] : 0;
+    }
+    if (g_record_file) fputc((int)(input & 0xF), g_record_file);
+    return input;
+}
+
+int sim_worker_main(void* arg) {
+    int w = (int)(intptr_t)arg;
+    for (;;) {
+        SDL_SemWait(g_job_go[w]);
+        if (SDL_AtomicGet(&g_workers_quit)) break;
+        g_job_func(g_job_begin[w], g_job_end[w]);
+        SDL_SemPost(g_job_done);
+    }
+    return 0;
+}
+
+// Fork-join parallel-for over [0, count). Small batches run inline: the
+// wakeup round-trip costs more than the work below PARALLEL_MIN_COUNT.
+void run_parallel(JobFunc fn, int count) {
+    if (g_sim_worker_count == 0 || count < PARALLEL_MIN_COUNT) {
+        fn(0, count);
+        return;
+    }
+    int per = count / (g_sim_worker_count + 1);
+    int start = 0;
+    g_job_func = fn;
+    for (int w = 0; w < g_sim_worker_count; w++) {
+        g_job_begin[w] = start;
+        g_job_end[w] = start + per;
+        start += per;
+        SDL_SemPost(g_job_go[w]);
+    }
+    fn(start, count); // main thread works the tail instead of idling
+    for (int w = 0; w < g_sim_worker_count; w++) SDL_SemWait(g_job_done);
+}
+
+// Fire-and-return variant: the whole range goes to the pool and the
+// main thread keeps doing other work until run_parallel_wait(). Only
+// one async fan-out may be outstanding (same one-job-kind rule as
+// run_parallel, which must not be called until the wait).
+void run_parallel_async(JobFunc fn, int count) {
+    if (g_sim_worker_count == 0 || count < PARALLEL_MIN_COUNT) {
+        fn(0, count);
+        g_prep_async = 0;
+        return;
+    }
+    int per = count / g_sim_worker_count;
+    int start = 0;
+    g_job_func = fn;
+    for (int w = 0; w < g_sim_worker_count; w++) {
+        g_job_begin[w] = start;
+        g_job_end[w] = (w == g_sim_worker_count - 1) ? count : start + per;
+        start += per;
+        SDL_SemPost(g_job_go[w]);
+    }
+    g_prep_async = g_sim_worker_count;
+}
+
+void run_parallel_wait() {
+    for (int w = 0; w < g_prep_async; w++) SDL_SemWait(g_job_done);
+    g_prep_async = 0;
+}
+
+void start_sim_workers() {
+    int cores = SDL_GetCPUCount();
+    int want = cores - 1; // leave a core for the main thread
+    if (want > MAX_SIM_WORKERS) want = MAX_SIM_WORKERS;
+    if (want < 0) want = 0;
+    SDL_AtomicSet(&g_workers_quit, 0);
+    g_job_done = SDL_CreateSemaphore(0);
+    if (!g_job_done) return;
+    for (int w = 0; w < want; w++) {
+        g_job_go[w] = SDL_CreateSemaphore(0);
+        if (!g_job_go[w]) break;
+        g_sim_workers[w] = SDL_CreateThread(sim_worker_main, "sim-worker", (void*)(intptr_t)w);
+        if (!g_sim_workers[w]) break;
+        g_sim_worker_count++;
+    }
+}
+
+void stop_sim_workers() {
+    SDL_AtomicSet(&g_workers_quit, 1);
+    for (int w = 0; w < g_sim_worker_count; w++) {
+        SDL_SemPost(g_job_go[w]);
+        SDL_WaitThread(g_sim_workers[w], NULL);
+        SDL_DestroySemaphore(g_job_go[w]);
+    }
+    g_sim_worker_count = 0;
+    if (g_job_done) SDL_DestroySemaphore(g_job_done);
+    g_job_done = NULL;
+}
+
+// Maps a free-running angle in degrees onto the quantized table step.
+// Masking handles negative angles (two's complement wrap is cyclic).
+int rot_step_for_angle(float degrees) {
+    return (int)(degrees * (ROT_STEPS / 360.0f)) & (ROT_STEPS - 1);
+}
+
+// Fills the shape bank with the same jagged outlines spawn_asteroid()
+// used to generate inline. Uses a fixed private LCG so the bank is
+// identical across runs and does not consume the simulation's rand()
+// stream.
+void init_shape_bank() {
+    unsigned lcg = 0xA57E701Du;
+    #define BANK_RAND(mod) ((int)((lcg = lcg * 1664525u + 1013904223u) >> 16) % (mod))
+    for (int size = 1; size <= 3; size++) {
+        for (int n = 0; n < SHAPES_PER_SIZE; n++) {
+            int verts = 8 + BANK_RAND(9);
+            float max_radius = 0.0f;
+            for (int j = 0; j < verts; j++) {
+                float angle = (float)j / verts * 2.0f * M_PI;
+                float radius_variance = (float)(size * 8 + BANK_RAND(size * 4));
+                if (radius_variance > max_radius) max_radius = radius_variance;
+                g_shape_vertices[size-1][n][j*2] = radius_variance * cosf(angle);
+                g_shape_vertices[size-1][n][j*2+1] = radius_variance * sinf(angle);
+            }
+            g_shape_num_vertices[size-1][n] = verts;
+            g_shape_radius[size-1][n] = max_radius;
+        }
+    }
+    #undef BANK_RAND
+}
+
 int initialize() {
+    g_perf_freq = SDL_GetPerformanceFrequency();
+    for (int i = 0; i < ROT_STEPS; i++) {
+        g_sin_table[i] = sinf((float)i * (2.0f * M_PI / ROT_STEPS));
+        g_cos_table[i] = cosf((float)i * (2.0f * M_PI / ROT_STEPS));
+    }
+    init_shape_bank();
+    start_sim_workers();
+    // The grid must read as empty until the first rebuild: autoplay
+    // samples AI input (and walks these lists) before the first
+    // update_game() has ever run.
+    for (int i = 0; i < GRID_COLS * GRID_ROWS; i++) g_grid_head[i] = -1;
+
+    g_rng_seed = g_headless ? HEADLESS_SEED : (unsigned)time(0);
+    if (g_replay_path) {
+        unsigned seed;
+        if (!replay_load(g_replay_path, &seed)) return 0;
+        g_rng_seed = seed; // re-simulate the recorded session exactly
+    }
+#if FEATURE_NET
+    // Co-op handshake settles the shared seed (the host's) before either
+    // side seeds its RNG. Lockstep replaces record/replay in this mode.
+    if (g_net_mode && !net_init()) return 0;
+#endif
+
+    if (g_headless) {
+        // Benchmark runs need no window, renderer or audio device, and a
+        // fixed seed (or the replay's seed) so runs are repeatable.
+        srand(g_rng_seed);
+        if (g_record_path && !replay_begin_record(g_record_path, g_rng_seed)) return 0;
+        return 1;
+    }
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) return 0;
     if (Mix_OpenAudio(SAMPLE_RATE, MIX_DEFAULT_FORMAT, 2, 2048) < 0) return 0;
-    g_window = SDL_CreateWindow("SDL Asteroids", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
+    g_window = SDL_CreateWindow("SDL Asteroids", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                                DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT,
+                                SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
     if (!g_window) return 0;
     g_renderer = SDL_CreateRenderer(g_window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
     if (!g_renderer) return 0;
-    srand(time(0));
-    create_sounds();
+    update_render_scale();
+    hud_atlas_init();
+    srand(g_rng_seed);
+    if (g_record_path && !replay_begin_record(g_record_path, g_rng_seed)) return 0;
+
+    // Audio comes up in the background; the game starts immediately and
+    // each effect becomes audible once its chunk pointer is published.
+    SDL_AtomicSet(&g_sound_queue_head, 0);
+    SDL_AtomicSet(&g_sound_queue_tail, 0);
+    SDL_AtomicSet(&g_audio_quit, 0);
+    g_sound_sem = SDL_CreateSemaphore(0);
+    if (g_sound_sem) {
+        g_audio_thread = SDL_CreateThread(audio_thread_main, "audio", NULL);
+        g_synth_thread = SDL_CreateThread(sound_synthesis_thread, "sound-synth", NULL);
+    }
+    if (!g_synth_thread) create_sounds(); // fall back to synchronous synthesis
+
+    // Telemetry follows the audio pattern: its own ring, semaphore and
+    // writer thread, so an SD-card stall never lands inside a frame.
+    telemetry_load_high_score();
+    SDL_AtomicSet(&g_telem_queue_head, 0);
+    SDL_AtomicSet(&g_telem_queue_tail, 0);
+    SDL_AtomicSet(&g_telem_quit, 0);
+    g_telem_sem = SDL_CreateSemaphore(0);
+    if (g_telem_sem) g_telem_thread = SDL_CreateThread(telemetry_thread_main, "telemetry", NULL);
     return 1;
 }
 
+// The rotation table doubles as the synthesis oscillator: one period
+// of sine in ROT_STEPS entries, indexed by fractional phase. The
+// quantization is inaudible under the noise and envelopes these
+// effects use, and it replaces ~11k libm sin() calls per bang buffer.
+float synth_sine(double phase) {
+    return g_sin_table[(int)(phase * ROT_STEPS) & (ROT_STEPS - 1)];
+}
+
+// Looks up (effect, pitch) in the cache, synthesizing the variant on a
+// miss. Audio-thread only. Eviction is LRU, but a slot used within
+// SAMPLE_EVICT_AGE_MS is never reclaimed -- its buffer may still be
+// feeding the mixer; if every slot is that fresh the caller falls back
+// to the base chunk rather than waiting.
+Mix_Chunk* sample_cache_get(int effect, int pitch) {
+    static const double base_freq[3] = {110.0, 220.0, 440.0};
+    static const double sweep[3] = {200.0, 400.0, 800.0};
+    static const double amp[3] = {8000.0, 6000.0, 4000.0};
+    static const double decay[3] = {4.0, 6.0, 10.0};
+    static const int samples[3] = {SAMPLE_RATE/4, SAMPLE_RATE/6, SAMPLE_RATE/10};
+    Uint32 now = SDL_GetTicks();
+
+    SampleVariant* victim = NULL;
+    for (int i = 0; i < SAMPLE_CACHE_SLOTS; i++) {
+        SampleVariant* v = &g_sample_cache[i];
+        if (v->chunk && v->effect == effect && v->pitch == pitch) {
+            v->last_used = now;
+            return v->chunk;
+        }
+        if (!v->chunk) { if (!victim || victim->chunk) victim = v; continue; }
+        if (now - v->last_used >= SAMPLE_EVICT_AGE_MS &&
+            (!victim || (victim->chunk && v->last_used < victim->last_used)))
+            victim = v;
+    }
+    if (!victim) return NULL;
+    if (victim->chunk) {
+        Mix_FreeChunk(victim->chunk);
+        free(victim->data);
+    }
+
+    int n = samples[effect];
+    Sint16* data = malloc(n * sizeof(Sint16));
+    if (!data) { victim->chunk = NULL; return NULL; }
+    // Pitch multiplier spans roughly +-15% around the base effect.
+    double pm = 0.85 + (double)pitch * (0.30 / (PITCH_STEPS - 1));
+    for (int i = 0; i < n; i++) {
+        double t = (double)i / SAMPLE_RATE;
+        double f = base_freq[effect] - t * sweep[effect];
+        double env = 1.0 - t * decay[effect];
+        if (env < 0.0) env = 0.0;
+        data[i] = (Sint16)(amp[effect] * synth_sine(f * t * pm) * env);
+    }
+    victim->chunk = Mix_QuickLoad_RAW((Uint8*)data, n * sizeof(Sint16));
+    if (!victim->chunk) { free(data); return NULL; }
+    victim->data = data;
+    victim->effect = effect;
+    victim->pitch = pitch;
+    victim->last_used = now;
+    return victim->chunk;
+}
+
+// Synthesizes the five base effects through the shared sine table
+// (synth_sine) rather than libm. Runs on the synthesis worker thread, so
+// it draws from a private LCG instead of the simulation's rand() stream
+// and publishes each chunk pointer only after the buffer is complete.
 void create_sounds() {
+    unsigned lcg = 0x5EED5EEDu;
+    #define SND_RAND() ((lcg = lcg * 1664525u + 1013904223u) >> 16 & 0xFF)
     {
         static Sint16 data[SAMPLE_RATE/20]; int len = sizeof(data);
-        for(int i=0; i<len/sizeof(Sint16); ++i) { data[i] = (Sint16)(3000 * ((rand() % 256) / 255.0 - 0.5)); }
+        for(int i=0; i<len/sizeof(Sint16); ++i) { data[i] = (Sint16)(3000 * (SND_RAND() / 255.0 - 0.5)); }
+        SDL_MemoryBarrierRelease();
         g_shoot_sound = Mix_QuickLoad_RAW((Uint8*)data, len);
     }
     {
         static Sint16 data[SAMPLE_RATE/10]; int len = sizeof(data);
-        for(int i=0; i<len/sizeof(Sint16); ++i) { data[i] = (Sint16)(1500 * sin(2.0*M_PI*110.0*((double)i/SAMPLE_RATE)) + 1000 * ((rand() % 256) / 255.0 - 0.5)); }
+        for(int i=0; i<len/sizeof(Sint16); ++i) { data[i] = (Sint16)(1500 * synth_sine(110.0*((double)i/SAMPLE_RATE)) + 1000 * (SND_RAND() / 255.0 - 0.5)); }
+        SDL_MemoryBarrierRelease();
         g_thrust_sound = Mix_QuickLoad_RAW((Uint8*)data, len);
     }
     {
         static Sint16 data[SAMPLE_RATE/4]; int len = sizeof(data);
-        for(int i=0; i<len/sizeof(Sint16); ++i) { double t=(double)i/SAMPLE_RATE; double f=110.0-(t*200.0); data[i] = (Sint16)(8000 * sin(2.0*M_PI*f*t)*(1.0-(t*4))); }
+        for(int i=0; i<len/sizeof(Sint16); ++i) { double t=(double)i/SAMPLE_RATE; double f=110.0-(t*200.0); data[i] = (Sint16)(8000 * synth_sine(f*t)*(1.0-(t*4))); }
+        SDL_MemoryBarrierRelease();
         g_bang_large_sound = Mix_QuickLoad_RAW((Uint8*)data, len);
     }
     {
         static Sint16 data[SAMPLE_RATE/6]; int len = sizeof(data);
-        for(int i=0; i<len/sizeof(Sint16); ++i) { double t=(double)i/SAMPLE_RATE; double f=220.0-(t*400.0); data[i] = (Sint16)(6000 * sin(2.0*M_PI*f*t)*(1.0-(t*6))); }
+        for(int i=0; i<len/sizeof(Sint16); ++i) { double t=(double)i/SAMPLE_RATE; double f=220.0-(t*400.0); data[i] = (Sint16)(6000 * synth_sine(f*t)*(1.0-(t*6))); }
+        SDL_MemoryBarrierRelease();
         g_bang_medium_sound = Mix_QuickLoad_RAW((Uint8*)data, len);
     }
     {
         static Sint16 data[SAMPLE_RATE/10]; int len = sizeof(data);
-        for(int i=0; i<len/sizeof(Sint16); ++i) { double t=(double)i/SAMPLE_RATE; double f=440.0-(t*800.0); data[i] = (Sint16)(4000 * sin(2.0*M_PI*f*t)*(1.0-(t*10))); }
+        for(int i=0; i<len/sizeof(Sint16); ++i) { double t=(double)i/SAMPLE_RATE; double f=440.0-(t*800.0); data[i] = (Sint16)(4000 * synth_sine(f*t)*(1.0-(t*10))); }
+        SDL_MemoryBarrierRelease();
         g_bang_small_sound = Mix_QuickLoad_RAW((Uint8*)data, len);
     }
+    #undef SND_RAND
+}
+
+int sound_synthesis_thread(void* data) {
+    (void)data;
+    create_sounds();
+    return 0;
+}
+
+// Drains the command ring and is the only thread that calls into
+// SDL_mixer after startup, so the mixer lock is never taken from the
+// simulation path.
+int audio_thread_main(void* data) {
+    (void)data;
+    for (;;) {
+        SDL_SemWait(g_sound_sem);
+        if (SDL_AtomicGet(&g_audio_quit)) break;
+        int head = SDL_AtomicGet(&g_sound_queue_head);
+        if (head == SDL_AtomicGet(&g_sound_queue_tail)) continue;
+        SDL_MemoryBarrierAcquire();
+        SoundCommand cmd = g_sound_queue[head & (SOUND_QUEUE_SIZE - 1)];
+        SDL_AtomicSet(&g_sound_queue_head, head + 1);
+        if (cmd.halt) {
+            Mix_HaltChannel(cmd.channel);
+        } else if (cmd.effect >= 0) {
+            Mix_Chunk* chunk = sample_cache_get(cmd.effect, cmd.pitch);
+            if (!chunk) { // cache saturated with in-flight buffers
+                if (cmd.effect == SND_BANG_LARGE) chunk = g_bang_large_sound;
+                else if (cmd.effect == SND_BANG_MEDIUM) chunk = g_bang_medium_sound;
+                else chunk = g_bang_small_sound;
+            }
+            if (chunk) {
+                // Scale the channel, never the chunk: chunk volume is
+                // sticky and would carry a coalesced boost into every
+                // later plain play of the same sample.
+                int ch = Mix_PlayChannel(cmd.channel, chunk, cmd.loops);
+                if (ch >= 0)
+                    Mix_Volume(ch, cmd.volume >= 0 ? cmd.volume : MIX_MAX_VOLUME);
+            }
+        } else if (cmd.chunk) {
+            // Channel volume persists too; reset it for unscaled plays.
+            int ch = Mix_PlayChannel(cmd.channel, cmd.chunk, cmd.loops);
+            if (ch >= 0) Mix_Volume(ch, MIX_MAX_VOLUME);
+        }
+    }
+    return 0;
+}
+
+// Producer side. Never blocks: if the ring is full the request is
+// dropped, which is the right failure mode mid-tick.
+void queue_sound(Mix_Chunk* chunk, int channel, int loops) {
+    if (!g_audio_thread || !chunk) return;
+    int tail = SDL_AtomicGet(&g_sound_queue_tail);
+    if (tail - SDL_AtomicGet(&g_sound_queue_head) >= SOUND_QUEUE_SIZE) return;
+    SoundCommand* cmd = &g_sound_queue[tail & (SOUND_QUEUE_SIZE - 1)];
+    cmd->chunk = chunk;
+    cmd->channel = channel;
+    cmd->loops = loops;
+    cmd->halt = 0;
+    cmd->effect = -1;
+    cmd->volume = -1;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&g_sound_queue_tail, tail + 1);
+    SDL_SemPost(g_sound_sem);
+}
+
+// Queues a pitch-varied effect; resolution against the sample cache
+// (and any lazy synthesis) happens on the audio thread.
+void queue_sound_pitched(int effect, int pitch, int volume) {
+    if (!g_audio_thread) return;
+    int tail = SDL_AtomicGet(&g_sound_queue_tail);
+    if (tail - SDL_AtomicGet(&g_sound_queue_head) >= SOUND_QUEUE_SIZE) return;
+    SoundCommand* cmd = &g_sound_queue[tail & (SOUND_QUEUE_SIZE - 1)];
+    cmd->chunk = NULL;
+    cmd->channel = -1;
+    cmd->loops = 0;
+    cmd->halt = 0;
+    cmd->effect = effect;
+    cmd->pitch = pitch;
+    cmd->volume = volume;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&g_sound_queue_tail, tail + 1);
+    SDL_SemPost(g_sound_sem);
+}
+
+// Tallies a kill for the coalescer; every kill in a class shares the
+// pitch of the first one, which keeps a chain explosion sounding like
+// one big event instead of a cluster.
+void record_kill(int effect, int pitch) {
+    if (effect < 0 || effect > 2) return;
+    if (g_kill_count[effect] == 0) g_kill_pitch[effect] = pitch;
+    g_kill_count[effect]++;
+}
+
+// End-of-tick flush: at most one play command per size class, volume
+// ramped with the kill count (a lone kill sits at 3/4 volume so the
+// ramp has headroom before it saturates at MIX_MAX_VOLUME).
+void flush_kill_sounds() {
+    for (int e = 0; e < 3; e++) {
+        if (g_kill_count[e] == 0) continue;
+        int vol = (MIX_MAX_VOLUME * 3) / 4 + (g_kill_count[e] - 1) * 8;
+        if (vol > MIX_MAX_VOLUME) vol = MIX_MAX_VOLUME;
+        queue_sound_pitched(e, g_kill_pitch[e], vol);
+        g_kill_count[e] = 0;
+    }
+}
+
+void queue_halt(int channel) {
+    if (!g_audio_thread) return;
+    int tail = SDL_AtomicGet(&g_sound_queue_tail);
+    if (tail - SDL_AtomicGet(&g_sound_queue_head) >= SOUND_QUEUE_SIZE) return;
+    SoundCommand* cmd = &g_sound_queue[tail & (SOUND_QUEUE_SIZE - 1)];
+    cmd->chunk = NULL;
+    cmd->channel = channel;
+    cmd->loops = 0;
+    cmd->halt = 1;
+    cmd->effect = -1;
+    cmd->volume = -1;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&g_sound_queue_tail, tail + 1);
+    SDL_SemPost(g_sound_sem);
+}
+
+// Scans the append-only log for the best recorded score. Runs once
+// during startup, before the first frame, so a slow card read can
+// never stall play. A record with a bad magic means a truncated tail
+// from a power cut; everything before it is still trusted.
+void telemetry_load_high_score() {
+    FILE* f = fopen(TELEM_PATH, "rb");
+    if (!f) return;
+    // The log may hold a mix of v1 ("ARTL") and v2 ("ART2") records --
+    // v2 appended gov_level -- so the record length follows the magic.
+    // All fields are contiguous Uint32s, so reading the v1 prefix into
+    // a v2 record is safe.
+    Uint32 magic;
+    while (fread(&magic, sizeof(magic), 1, f) == 1) {
+        TelemetryRecord rec;
+        size_t rest;
+        if (magic == TELEM_MAGIC) rest = sizeof(rec) - sizeof(Uint32);
+        else if (magic == TELEM_MAGIC_V1) rest = sizeof(rec) - 2 * sizeof(Uint32);
+        else break;
+        if (fread(&rec.score, 1, rest, f) != rest) break;
+        if ((int)rec.score > g_high_score) g_high_score = (int)rec.score;
+    }
+    fclose(f);
+}
+
+// Writer thread: drains the ring and appends records with buffered
+// stdio. fflush pushes bytes to the OS; the actual media sync is left
+// to the kernel so the 50 ms+ card stall happens on nobody's clock.
+int telemetry_thread_main(void* data) {
+    (void)data;
+    FILE* f = fopen(TELEM_PATH, "ab");
+    for (;;) {
+        SDL_SemWait(g_telem_sem);
+        int head = SDL_AtomicGet(&g_telem_queue_head);
+        int wrote = 0;
+        while (head != SDL_AtomicGet(&g_telem_queue_tail)) {
+            SDL_MemoryBarrierAcquire();
+            if (f) fwrite(&g_telem_queue[head & (TELEM_QUEUE_SIZE - 1)],
+                          sizeof(TelemetryRecord), 1, f);
+            head++;
+            wrote = 1;
+        }
+        SDL_AtomicSet(&g_telem_queue_head, head);
+        if (f && wrote) fflush(f);
+        if (SDL_AtomicGet(&g_telem_quit) &&
+            head == SDL_AtomicGet(&g_telem_queue_tail)) break;
+    }
+    if (f) fclose(f);
+    return 0;
+}
+
+// Snapshots the session counters into a record. Called from the game
+// thread at level boundaries and shutdown; if the ring is somehow full
+// the record is dropped rather than blocking a tick.
+void queue_telemetry(int end_of_session) {
+    if (!g_telem_thread) return;
+    int tail = SDL_AtomicGet(&g_telem_queue_tail);
+    if (tail - SDL_AtomicGet(&g_telem_queue_head) >= TELEM_QUEUE_SIZE) return;
+    TelemetryRecord* rec = &g_telem_queue[tail & (TELEM_QUEUE_SIZE - 1)];
+    rec->magic = TELEM_MAGIC;
+    rec->score = (Uint32)g_score;
+    rec->level = (Uint32)g_level;
+    rec->ticks = g_session_ticks;
+    rec->peak_asteroids = g_session_peak_asteroids;
+    rec->frame_p50_us = (Uint32)prof_percentile_us(PROF_FRAME, 0.50);
+    rec->frame_p99_us = (Uint32)prof_percentile_us(PROF_FRAME, 0.99);
+    rec->end_of_session = (Uint32)end_of_session;
+    rec->gov_level = (Uint32)g_gov_level;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&g_telem_queue_tail, tail + 1);
+    SDL_SemPost(g_telem_sem);
 }
 
 void setup_level() {
-    g_ship = (Ship){SCREEN_WIDTH / 2.0f, SCREEN_HEIGHT / 2.0f, 0.0f, 0.0f, -90.0f, 1, RESPAWN_INVINCIBILITY};
-    for (int i = 0; i < MAX_BULLETS; i++) g_bullets[i].active = 0;
-    for (int i = 0; i < MAX_ASTEROIDS; i++) g_asteroids[i].alive = 0;
-    
+    g_ship = (Ship){WORLD_WIDTH / 2.0f, WORLD_HEIGHT / 2.0f,
+                    WORLD_WIDTH / 2.0f, WORLD_HEIGHT / 2.0f,
+                    0.0f, 0.0f, -90.0f, 1, RESPAWN_INVINCIBILITY};
+    g_ship2 = g_ship;
+    g_ship2.x -= 60.0f;
+    g_ship2.prev_x = g_ship2.x;
+    g_ship2.alive = g_net_mode ? 1 : 0;
+    g_bullet_count = 0;
+    g_asteroid_count = 0;
+    g_particle_count = 0;
+
     for (int i = 0; i < g_level + 3; i++) {
         float x, y;
         do {
             if (rand() % 2 == 0) {
-                x = (rand() % 2 == 0) ? 0.0f - SHIP_SIZE*4 : SCREEN_WIDTH + SHIP_SIZE*4;
-                y = rand() % SCREEN_HEIGHT;
+                x = (rand() % 2 == 0) ? 0.0f - SHIP_SIZE*4 : WORLD_WIDTH + SHIP_SIZE*4;
+                y = rand() % WORLD_HEIGHT;
             } else {
-                x = rand() % SCREEN_WIDTH;
-                y = (rand() % 2 == 0) ? 0.0f - SHIP_SIZE*4 : SCREEN_HEIGHT + SHIP_SIZE*4;
+                x = rand() % WORLD_WIDTH;
+                y = (rand() % 2 == 0) ? 0.0f - SHIP_SIZE*4 : WORLD_HEIGHT + SHIP_SIZE*4;
             }
         } while (hypotf(x - g_ship.x, y - g_ship.y) < 200.0f); // Don't spawn on top of player
         spawn_asteroid(x, y, 3);
     }
 }
 
+// In-process restart: flush a telemetry record for the session so far,
+// zero the progress state and rebuild level 1. No SDL, mixer or
+// synthesis work is repeated, so the restart is instant.
+void reset_game() {
+    if (g_session_ticks > 0) queue_telemetry(0); // nothing to log at first boot
+    g_session_ticks = 0;
+    g_session_peak_asteroids = 0;
+    g_score = 0;
+    g_lives = 3;
+    g_level = 1;
+    g_game_over = 0;
+    g_fire_cooldown = 0;
+    g_fire_cooldown2 = 0;
+    g_split_count = 0;
+    g_ai_target = -1;
+    g_ai_retarget = 0;
+    setup_level();
+}
+
+void snapshot_save() {
+    size_t need = (size_t)g_asteroid_count * (9 * sizeof(float) + 4 * sizeof(int) + sizeof(Uint8))
+                + (size_t)g_bullet_count * (6 * sizeof(float) + sizeof(int))
+                + (size_t)g_particle_count * (6 * sizeof(float) + sizeof(int));
+    if (g_snapshot.blob_capacity < need) {
+        g_snapshot.blob = realloc(g_snapshot.blob, need);
+        g_snapshot.blob_capacity = need;
+    }
+    g_snapshot.asteroid_count = g_asteroid_count;
+    g_snapshot.bullet_count = g_bullet_count;
+    g_snapshot.particle_count = g_particle_count;
+    g_snapshot.ship = g_ship;
+    g_snapshot.ship2 = g_ship2;
+    g_snapshot.score = g_score;
+    g_snapshot.lives = g_lives;
+    g_snapshot.level = g_level;
+    g_snapshot.game_over = g_game_over;
+    g_snapshot.fire_cooldown = g_fire_cooldown;
+    g_snapshot.fire_cooldown2 = g_fire_cooldown2;
+    g_snapshot.blob_len = need;
+    Uint8* p = g_snapshot.blob;
+    #define PUT(arr, bytes) do { memcpy(p, (arr), (bytes)); p += (bytes); } while (0)
+    int n = g_asteroid_count;
+    PUT(g_asteroid_x, n * sizeof(float));
+    PUT(g_asteroid_y, n * sizeof(float));
+    PUT(g_asteroid_prev_x, n * sizeof(float));
+    PUT(g_asteroid_prev_y, n * sizeof(float));
+    PUT(g_asteroid_vx, n * sizeof(float));
+    PUT(g_asteroid_vy, n * sizeof(float));
+    PUT(g_asteroid_angle, n * sizeof(float));
+    PUT(g_asteroid_rot_speed, n * sizeof(float));
+    PUT(g_asteroid_radius, n * sizeof(float));
+    PUT(g_asteroid_size, n * sizeof(int));
+    PUT(g_asteroid_shape, n * sizeof(int));
+    PUT(g_asteroid_dead, n * sizeof(int));
+    PUT(g_asteroid_cell, n * sizeof(int));
+    PUT(g_asteroid_visible, n * sizeof(Uint8));
+    PUT(g_bullet_x, g_bullet_count * sizeof(float));
+    PUT(g_bullet_y, g_bullet_count * sizeof(float));
+    PUT(g_bullet_prev_x, g_bullet_count * sizeof(float));
+    PUT(g_bullet_prev_y, g_bullet_count * sizeof(float));
+    PUT(g_bullet_vx, g_bullet_count * sizeof(float));
+    PUT(g_bullet_vy, g_bullet_count * sizeof(float));
+    PUT(g_bullet_lifetime, g_bullet_count * sizeof(int));
+    PUT(g_particle_x, g_particle_count * sizeof(float));
+    PUT(g_particle_y, g_particle_count * sizeof(float));
+    PUT(g_particle_prev_x, g_particle_count * sizeof(float));
+    PUT(g_particle_prev_y, g_particle_count * sizeof(float));
+    PUT(g_particle_vx, g_particle_count * sizeof(float));
+    PUT(g_particle_vy, g_particle_count * sizeof(float));
+    PUT(g_particle_life, g_particle_count * sizeof(int));
+    #undef PUT
+    g_snapshot.valid = 1;
+}
+
+void snapshot_restore() {
+    if (!g_snapshot.valid) return;
+    while (g_asteroid_capacity < g_snapshot.asteroid_count) {
+        int before = g_asteroid_capacity;
+        grow_asteroid_storage();
+        // Growth clamps at ASTEROID_HARD_CAP; a count beyond it means
+        // the snapshot is corrupt, and looping would never terminate.
+        if (g_asteroid_capacity == before) return;
+    }
+    g_asteroid_count = g_snapshot.asteroid_count;
+    g_bullet_count = g_snapshot.bullet_count;
+    g_particle_count = g_snapshot.particle_count;
+    g_ship = g_snapshot.ship;
+    g_ship2 = g_snapshot.ship2;
+    g_score = g_snapshot.score;
+    g_lives = g_snapshot.lives;
+    g_level = g_snapshot.level;
+    g_game_over = g_snapshot.game_over;
+    g_fire_cooldown = g_snapshot.fire_cooldown;
+    g_fire_cooldown2 = g_snapshot.fire_cooldown2;
+    g_split_count = 0;
+    const Uint8* p = g_snapshot.blob;
+    #define GET(arr, bytes) do { memcpy((arr), p, (bytes)); p += (bytes); } while (0)
+    int n = g_asteroid_count;
+    GET(g_asteroid_x, n * sizeof(float));
+    GET(g_asteroid_y, n * sizeof(float));
+    GET(g_asteroid_prev_x, n * sizeof(float));
+    GET(g_asteroid_prev_y, n * sizeof(float));
+    GET(g_asteroid_vx, n * sizeof(float));
+    GET(g_asteroid_vy, n * sizeof(float));
+    GET(g_asteroid_angle, n * sizeof(float));
+    GET(g_asteroid_rot_speed, n * sizeof(float));
+    GET(g_asteroid_radius, n * sizeof(float));
+    GET(g_asteroid_size, n * sizeof(int));
+    GET(g_asteroid_shape, n * sizeof(int));
+    GET(g_asteroid_dead, n * sizeof(int));
+    GET(g_asteroid_cell, n * sizeof(int));
+    GET(g_asteroid_visible, n * sizeof(Uint8));
+    GET(g_bullet_x, g_bullet_count * sizeof(float));
+    GET(g_bullet_y, g_bullet_count * sizeof(float));
+    GET(g_bullet_prev_x, g_bullet_count * sizeof(float));
+    GET(g_bullet_prev_y, g_bullet_count * sizeof(float));
+    GET(g_bullet_vx, g_bullet_count * sizeof(float));
+    GET(g_bullet_vy, g_bullet_count * sizeof(float));
+    GET(g_bullet_lifetime, g_bullet_count * sizeof(int));
+    GET(g_particle_x, g_particle_count * sizeof(float));
+    GET(g_particle_y, g_particle_count * sizeof(float));
+    GET(g_particle_prev_x, g_particle_count * sizeof(float));
+    GET(g_particle_prev_y, g_particle_count * sizeof(float));
+    GET(g_particle_vx, g_particle_count * sizeof(float));
+    GET(g_particle_vy, g_particle_count * sizeof(float));
+    GET(g_particle_life, g_particle_count * sizeof(int));
+    #undef GET
+    // All bytes 0xFF is -1: marks every rotated-vertex cache entry
+    // dirty, so the prep workers regenerate them on the next frame.
+    memset(g_asteroid_rot_step, 0xFF, n * sizeof(int));
+    g_ai_target = -1;
+    g_ai_retarget = 0;
+}
+
+#if FEATURE_NET
+// --- Networked co-op ---
+// Lockstep: both cabinets run the identical simulation from a shared
+// seed, exchanging one input byte per tick. Inputs are sampled
+// NET_DELAY_TICKS ahead and every packet repeats the last
+// NET_INPUT_REDUNDANCY bytes, so isolated datagram loss costs nothing.
+// If the client still stalls, it requests a state resync: the host
+// XORs the current snapshot blob against the last acked one and
+// run-length encodes the zero bytes -- a few KB for a busy field
+// instead of a full dump. Every buffer here is preallocated.
+
+int net_init() {
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return 0;
+#endif
+    g_net_sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (g_net_sock == INVALID_SOCKET) return 0;
+    g_net_base_blob = malloc(NET_BLOB_MAX);
+    g_net_sync_buf = malloc(NET_SYNC_MAX);
+    if (!g_net_base_blob || !g_net_sync_buf) return 0;
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    if (g_net_mode == 1) {
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(NET_PORT);
+        if (bind(g_net_sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) return 0;
+        // Wait for the join datagram; its source address is the peer.
+        printf("net: hosting on port %d, waiting for player 2...\n", NET_PORT);
+        for (;;) {
+            Uint8 pkt[16];
+            struct sockaddr_in from;
+            socklen_t from_len = sizeof(from);
+            int n = (int)recvfrom(g_net_sock, (char*)pkt, sizeof(pkt), 0,
+                                  (struct sockaddr*)&from, &from_len);
+            if (n >= 1 && pkt[0] == 'J') {
+                g_net_peer = from;
+                g_net_have_peer = 1;
+                Uint8 reply[5] = {'S'};
+                memcpy(reply + 1, &g_rng_seed, 4);
+                sendto(g_net_sock, (char*)reply, sizeof(reply), 0,
+                       (struct sockaddr*)&g_net_peer, sizeof(g_net_peer));
+                break;
+            }
+        }
+    } else {
+        memset(&g_net_peer, 0, sizeof(g_net_peer));
+        g_net_peer.sin_family = AF_INET;
+        g_net_peer.sin_port = htons(NET_PORT);
+        g_net_peer.sin_addr.s_addr = inet_addr(g_net_join_addr);
+        g_net_have_peer = 1;
+        printf("net: joining %s...\n", g_net_join_addr);
+        for (;;) {
+            Uint8 join = 'J';
+            sendto(g_net_sock, (char*)&join, 1, 0,
+                   (struct sockaddr*)&g_net_peer, sizeof(g_net_peer));
+            SDL_Delay(100);
+            Uint8 pkt[16];
+            int n = (int)recv(g_net_sock, (char*)pkt, sizeof(pkt), 0);
+            if (n >= 5 && pkt[0] == 'S') {
+                memcpy(&g_rng_seed, pkt + 1, 4); // host's seed wins
+                break;
+            }
+        }
+    }
+    // Non-blocking from here on: the per-tick pump never waits.
+#ifdef _WIN32
+    u_long nb = 1;
+    ioctlsocket(g_net_sock, FIONBIO, &nb);
+#else
+    fcntl(g_net_sock, F_SETFL, fcntl(g_net_sock, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    // The first delayed ticks have no sampled input on either side.
+    memset(g_net_remote_have, 0, sizeof(g_net_remote_have));
+    for (Uint32 t = 0; t < NET_DELAY_TICKS; t++) {
+        g_net_local_inputs[t] = 0;
+        g_net_remote_inputs[t] = 0;
+        g_net_remote_have[t] = 1;
+    }
+    g_net_local_next = NET_DELAY_TICKS;
+    printf("net: connected\n");
+    return 1;
+}
+
+// XOR cur against base (tail past base_len passes through verbatim) and
+// RLE the zeros: the stream is repeated [zero_run u16][literal_len u16]
+// [literal bytes]. Returns the encoded length, or 0 when it would not
+// fit in max_out -- for a nonempty input a successful encode is always
+// at least one 4-byte header, so 0 is unambiguous.
+size_t net_encode_delta(const Uint8* cur, size_t cur_len,
+                        const Uint8* base, size_t base_len,
+                        Uint8* out, size_t max_out) {
+    size_t in = 0, o = 0;
+    while (in < cur_len) {
+        size_t zeros = 0;
+        while (in + zeros < cur_len && zeros < 65535) {
+            Uint8 d = cur[in + zeros] ^ (in + zeros < base_len ? base[in + zeros] : 0);
+            if (d != 0) break;
+            zeros++;
+        }
+        size_t lit = 0;
+        while (in + zeros + lit < cur_len && lit < 65535) {
+            size_t k = in + zeros + lit;
+            Uint8 d = cur[k] ^ (k < base_len ? base[k] : 0);
+            if (d == 0) break; // run ends at the next zero
+            lit++;
+        }
+        if (o + 4 + lit > max_out) return 0;
+        out[o++] = (Uint8)(zeros & 0xFF);
+        out[o++] = (Uint8)(zeros >> 8);
+        out[o++] = (Uint8)(lit & 0xFF);
+        out[o++] = (Uint8)(lit >> 8);
+        for (size_t k = 0; k < lit; k++) {
+            size_t idx = in + zeros + k;
+            out[o++] = cur[idx] ^ (idx < base_len ? base[idx] : 0);
+        }
+        in += zeros + lit;
+    }
+    return o;
+}
+
+void net_apply_delta(Uint8* cur, size_t cur_len,
+                     const Uint8* base, size_t base_len,
+                     const Uint8* delta, size_t delta_len) {
+    size_t in = 0, o = 0;
+    while (o + 4 <= delta_len && in < cur_len) {
+        size_t zeros = delta[o] | ((size_t)delta[o+1] << 8);
+        size_t lit = delta[o+2] | ((size_t)delta[o+3] << 8);
+        o += 4;
+        for (size_t k = 0; k < zeros && in < cur_len; k++, in++)
+            cur[in] = in < base_len ? base[in] : 0;
+        for (size_t k = 0; k < lit && o < delta_len && in < cur_len; k++, in++, o++)
+            cur[in] = delta[o] ^ (in < base_len ? base[in] : 0);
+    }
+}
+
+// Host side: capture the current state, delta it against the last
+// acked baseline and stream it out in MTU-sized chunks. The payload is
+// [meta GameSnapshot scalars][tick][format byte][entity blob], where
+// format 0 is the RLE delta and format 1 a raw dump -- the fallback
+// when the delta would not fit (the RLE worst case can outgrow its
+// input, and the buffer is sized for the raw blob).
+void net_send_resync() {
+    snapshot_save();
+    size_t meta = sizeof(GameSnapshot) + 5;
+    memcpy(g_net_sync_buf, &g_snapshot, sizeof(GameSnapshot));
+    memcpy(g_net_sync_buf + sizeof(GameSnapshot), &g_net_tick, 4);
+    g_net_sync_buf[sizeof(GameSnapshot) + 4] = 0;
+    size_t delta = net_encode_delta(g_snapshot.blob, g_snapshot.blob_len,
+                                    g_net_base_blob, g_net_base_len,
+                                    g_net_sync_buf + meta, NET_SYNC_MAX - meta);
+    if (delta == 0 && g_snapshot.blob_len > 0) {
+        // Encoder overflow (0 is unambiguous: any nonempty encode is
+        // at least one header). Ship the blob verbatim instead.
+        g_net_sync_buf[sizeof(GameSnapshot) + 4] = 1;
+        memcpy(g_net_sync_buf + meta, g_snapshot.blob, g_snapshot.blob_len);
+        delta = g_snapshot.blob_len;
+    }
+    size_t total = meta + delta;
+    g_net_sync_id++;
+    for (size_t off = 0; off < total; off += NET_CHUNK) {
+        Uint16 len = (Uint16)(total - off < NET_CHUNK ? total - off : NET_CHUNK);
+        Uint8 pkt[15 + NET_CHUNK];
+        pkt[0] = 'D';
+        memcpy(pkt + 1, &g_net_sync_id, 4);
+        Uint32 t32 = (Uint32)total, o32 = (Uint32)off;
+        memcpy(pkt + 5, &t32, 4);
+        memcpy(pkt + 9, &o32, 4);
+        memcpy(pkt + 13, &len, 2);
+        memcpy(pkt + 15, g_net_sync_buf + off, len);
+        sendto(g_net_sock, (char*)pkt, 15 + len, 0,
+               (struct sockaddr*)&g_net_peer, sizeof(g_net_peer));
+    }
+}
+
+// Client side: a fully reassembled sync image replaces local state.
+void net_apply_resync() {
+    if (g_net_sync_total < sizeof(GameSnapshot) + 5) return; // truncated header
+    GameSnapshot meta;
+    memcpy(&meta, g_net_sync_buf, sizeof(meta));
+    Uint32 tick;
+    memcpy(&tick, g_net_sync_buf + sizeof(GameSnapshot), 4);
+    Uint8 format = g_net_sync_buf[sizeof(GameSnapshot) + 4];
+    size_t delta_len = g_net_sync_total - sizeof(GameSnapshot) - 5;
+
+    // Validate the wire counts against the compiled pools before any
+    // of them drive an allocation or a restore: a corrupt packet (or a
+    // peer built with different caps) must be dropped, not applied.
+    size_t expect = (size_t)meta.asteroid_count * (9 * sizeof(float) + 4 * sizeof(int) + 1)
+                  + (size_t)meta.bullet_count * (6 * sizeof(float) + sizeof(int))
+                  + (size_t)meta.particle_count * (6 * sizeof(float) + sizeof(int));
+    if (meta.asteroid_count < 0 || meta.asteroid_count > ASTEROID_HARD_CAP ||
+        meta.bullet_count < 0 || meta.bullet_count > MAX_BULLETS ||
+        meta.particle_count < 0 || meta.particle_count > MAX_PARTICLES ||
+        meta.blob_len != expect ||
+        (format == 1 && delta_len != meta.blob_len) || format > 1) {
+        fprintf(stderr, "net: dropping resync with impossible counts\n");
+        return;
+    }
+
+    Uint8* blob = g_snapshot.blob; // keep our preallocated blob
+    size_t cap = g_snapshot.blob_capacity;
+    if (cap < meta.blob_len) {
+        blob = realloc(blob, meta.blob_len);
+        cap = meta.blob_len;
+    }
+    if (format == 1) {
+        memcpy(blob, g_net_sync_buf + sizeof(GameSnapshot) + 5, delta_len);
+    } else {
+        net_apply_delta(blob, meta.blob_len, g_net_base_blob, g_net_base_len,
+                        g_net_sync_buf + sizeof(GameSnapshot) + 5, delta_len);
+    }
+    g_snapshot = meta;
+    g_snapshot.blob = blob;
+    g_snapshot.blob_capacity = cap;
+    g_snapshot.valid = 1;
+    snapshot_restore();
+
+    // The applied state becomes the new baseline on both ends.
+    memcpy(g_net_base_blob, blob, meta.blob_len);
+    g_net_base_len = meta.blob_len;
+    Uint8 ack[5] = {'A'};
+    memcpy(ack + 1, &g_net_sync_id, 4);
+    sendto(g_net_sock, (char*)ack, sizeof(ack), 0,
+           (struct sockaddr*)&g_net_peer, sizeof(g_net_peer));
+
+    // Jump to the host's tick; input history before it is obsolete.
+    g_net_tick = tick;
+    g_net_local_next = tick;
+    memset(g_net_remote_have, 0, sizeof(g_net_remote_have));
+    g_net_stall_frames = 0;
+}
+
+// Drains every pending datagram. Called once per frame and before each
+// lockstep tick; never blocks.
+void net_pump() {
+    Uint8 pkt[15 + NET_CHUNK];
+    for (;;) {
+        int n = (int)recv(g_net_sock, (char*)pkt, sizeof(pkt), 0);
+        if (n <= 0) break;
+        if (pkt[0] == 'I' && n >= 6) {
+            Uint32 base_tick;
+            memcpy(&base_tick, pkt + 1, 4);
+            int count = pkt[5];
+            if (n < 6 + count) continue;
+            for (int k = 0; k < count; k++) {
+                Uint32 t = base_tick + k;
+                // Only accept inputs inside the ring window ahead of the
+                // current tick; older ones are already consumed.
+                if (t < g_net_tick || t >= g_net_tick + NET_INPUT_WINDOW) continue;
+                g_net_remote_inputs[t & (NET_INPUT_WINDOW - 1)] = pkt[6 + k];
+                g_net_remote_have[t & (NET_INPUT_WINDOW - 1)] = 1;
+            }
+        } else if (pkt[0] == 'R' && g_net_mode == 1) {
+            net_send_resync();
+        } else if (pkt[0] == 'D' && g_net_mode == 2 && n >= 15) {
+            Uint32 id, total, off;
+            Uint16 len;
+            memcpy(&id, pkt + 1, 4);
+            memcpy(&total, pkt + 5, 4);
+            memcpy(&off, pkt + 9, 4);
+            memcpy(&len, pkt + 13, 2);
+            // Compare against the remainder rather than off + len:
+            // the sum is Uint32 arithmetic and a hostile off near the
+            // top of the range would wrap it past the check. The host
+            // only ever sends chunks on NET_CHUNK boundaries.
+            if (total > NET_SYNC_MAX || off > total || len > total - off ||
+                off % NET_CHUNK != 0 || n < 15 + len) continue;
+            if (id != g_net_sync_id) { // new sync image begins
+                g_net_sync_id = id;
+                g_net_sync_total = total;
+                g_net_sync_got = 0;
+                memset(g_net_sync_have, 0, sizeof(g_net_sync_have));
+            }
+            if (total != g_net_sync_total) continue; // forged or stale header
+            // UDP duplicates are routine; count every chunk once so a
+            // repeated datagram can't complete an image with holes.
+            if (g_net_sync_have[off / NET_CHUNK]) continue;
+            g_net_sync_have[off / NET_CHUNK] = 1;
+            memcpy(g_net_sync_buf + off, pkt + 15, len);
+            g_net_sync_got += len;
+            if (g_net_sync_got >= g_net_sync_total) net_apply_resync();
+        } else if (pkt[0] == 'A' && g_net_mode == 1 && n >= 5) {
+            // Client applied the sync image: promote it to the baseline.
+            memcpy(g_net_base_blob, g_snapshot.blob, g_snapshot.blob_len);
+            g_net_base_len = g_snapshot.blob_len;
+        }
+    }
+}
+
+// Samples and sends the local input for the delayed tick (once), then
+// reports whether the remote byte for the current tick has arrived.
+// Returns 0 to stall the simulation; repeated stalls trigger a resync
+// request on the client.
+int net_tick_ready(unsigned local_input) {
+    if (g_net_local_next < g_net_tick + NET_INPUT_WINDOW &&
+        g_net_local_next >= g_net_tick) {
+        g_net_local_inputs[g_net_local_next & (NET_INPUT_WINDOW - 1)] = (Uint8)(local_input & 0xF);
+        g_net_local_next++;
+    }
+    // Send the newest inputs with redundancy; 9 bytes of payload per tick.
+    Uint32 count = g_net_local_next > NET_INPUT_REDUNDANCY ? NET_INPUT_REDUNDANCY : g_net_local_next;
+    Uint32 base = g_net_local_next - count;
+    Uint8 pkt[6 + NET_INPUT_REDUNDANCY];
+    pkt[0] = 'I';
+    memcpy(pkt + 1, &base, 4);
+    pkt[5] = (Uint8)count;
+    for (Uint32 k = 0; k < count; k++)
+        pkt[6 + k] = g_net_local_inputs[(base + k) & (NET_INPUT_WINDOW - 1)];
+    sendto(g_net_sock, (char*)pkt, 6 + count, 0,
+           (struct sockaddr*)&g_net_peer, sizeof(g_net_peer));
+
+    if (!g_net_remote_have[g_net_tick & (NET_INPUT_WINDOW - 1)]) {
+        if (++g_net_stall_frames >= NET_STALL_RESYNC && g_net_mode == 2) {
+            Uint8 req = 'R';
+            sendto(g_net_sock, (char*)&req, 1, 0,
+                   (struct sockaddr*)&g_net_peer, sizeof(g_net_peer));
+            g_net_stall_frames = 0;
+        }
+        return 0;
+    }
+    g_net_stall_frames = 0;
+    return 1;
+}
+
+void net_shutdown() {
+    if (g_net_sock != INVALID_SOCKET) {
+#ifdef _WIN32
+        closesocket(g_net_sock);
+        WSACleanup();
+#else
+        close(g_net_sock);
+#endif
+        g_net_sock = INVALID_SOCKET;
+    }
+    free(g_net_base_blob); g_net_base_blob = NULL;
+    free(g_net_sync_buf); g_net_sync_buf = NULL;
+}
+#endif // FEATURE_NET
+
+// Doubles the asteroid arena (first allocation is one chunk). All
+// parallel arrays move together so indices stay interchangeable.
+void grow_asteroid_storage() {
+    int cap = g_asteroid_capacity ? g_asteroid_capacity * 2 : ASTEROID_CHUNK;
+    if (cap > ASTEROID_HARD_CAP) cap = ASTEROID_HARD_CAP;
+    g_asteroid_x = realloc(g_asteroid_x, cap * sizeof(float));
+    g_asteroid_y = realloc(g_asteroid_y, cap * sizeof(float));
+    g_asteroid_prev_x = realloc(g_asteroid_prev_x, cap * sizeof(float));
+    g_asteroid_prev_y = realloc(g_asteroid_prev_y, cap * sizeof(float));
+    g_asteroid_vx = realloc(g_asteroid_vx, cap * sizeof(float));
+    g_asteroid_vy = realloc(g_asteroid_vy, cap * sizeof(float));
+    g_asteroid_angle = realloc(g_asteroid_angle, cap * sizeof(float));
+    g_asteroid_rot_speed = realloc(g_asteroid_rot_speed, cap * sizeof(float));
+    g_asteroid_size = realloc(g_asteroid_size, cap * sizeof(int));
+    g_asteroid_radius = realloc(g_asteroid_radius, cap * sizeof(float));
+    g_asteroid_dead = realloc(g_asteroid_dead, cap * sizeof(int));
+    g_asteroid_shape = realloc(g_asteroid_shape, cap * sizeof(int));
+    g_asteroid_rot_step = realloc(g_asteroid_rot_step, cap * sizeof(int));
+    g_asteroid_rotated = realloc(g_asteroid_rotated, cap * sizeof(*g_asteroid_rotated));
+    g_asteroid_visible = realloc(g_asteroid_visible, cap * sizeof(Uint8));
+    g_grid_next = realloc(g_grid_next, cap * sizeof(int));
+    g_asteroid_cell = realloc(g_asteroid_cell, cap * sizeof(int));
+    g_asteroid_capacity = cap;
+}
+
 void spawn_asteroid(float x, float y, int size) {
     // --- BUG FIX ---
     // Added a safety check to prevent creating an asteroid of size 0 or less.
     if (size < 1) return;
 
-    for (int i = 0; i < MAX_ASTEROIDS; i++) {
-        if (!g_asteroids[i].alive) {
-            g_asteroids[i].alive = 1;
-            g_asteroids[i].x = x;
-            g_asteroids[i].y = y;
-            g_asteroids[i].vx = ((rand() % 200) - 100) / 100.0f;
-            g_asteroids[i].vy = ((rand() % 200) - 100) / 100.0f;
-            g_asteroids[i].angle = 0.0f;
-            g_asteroids[i].rotation_speed = ((rand() % 100) - 50) / 50.0f;
-            g_asteroids[i].size = size;
-            g_asteroids[i].num_vertices = 8 + rand() % 9; // Max 16 vertices
-            
-            for (int j = 0; j < g_asteroids[i].num_vertices; j++) {
-                float angle = (float)j / g_asteroids[i].num_vertices * 2.0f * M_PI;
-                float radius_variance = (float)(size * 8 + (rand() % (size * 4)));
-                g_asteroids[i].vertices[j*2] = radius_variance * cosf(angle);
-                g_asteroids[i].vertices[j*2+1] = radius_variance * sinf(angle);
-            }
-            return;
+    int i;
+    if (g_asteroid_count < g_asteroid_capacity) {
+        i = g_asteroid_count++;
+    } else if (g_asteroid_capacity < ASTEROID_HARD_CAP) {
+        grow_asteroid_storage();
+        i = g_asteroid_count++;
+    } else {
+        // Memory budget hit: recycle the slot of the asteroid farthest
+        // from the player, which is the one least likely to matter.
+        int farthest = 0;
+        float best = -1.0f;
+        for (int j = 0; j < g_asteroid_count; j++) {
+            float dx = g_asteroid_x[j] - g_ship.x;
+            float dy = g_asteroid_y[j] - g_ship.y;
+            float d2 = dx * dx + dy * dy;
+            if (d2 > best) { best = d2; farthest = j; }
         }
+        i = farthest;
     }
+    g_asteroid_x[i] = x;
+    g_asteroid_y[i] = y;
+    g_asteroid_prev_x[i] = x;
+    g_asteroid_prev_y[i] = y;
+    g_asteroid_vx[i] = ((rand() % 200) - 100) / 100.0f;
+    g_asteroid_vy[i] = ((rand() % 200) - 100) / 100.0f;
+    g_asteroid_angle[i] = 0.0f;
+    g_asteroid_rot_speed[i] = ((rand() % 100) - 50) / 50.0f;
+    g_asteroid_size[i] = size;
+    g_asteroid_dead[i] = 0;
+    g_asteroid_rot_step[i] = -1;
+    g_asteroid_shape[i] = rand() % SHAPES_PER_SIZE;
+    g_asteroid_radius[i] = g_shape_radius[size-1][g_asteroid_shape[i]];
+    g_asteroid_visible[i] = 1; // reclassified on the next integration pass
 }
 
-void fire_bullet() {
-    if (!g_ship.alive) return;
-    for (int i = 0; i < MAX_BULLETS; i++) {
-        if (!g_bullets[i].active) {
-            g_bullets[i].active = 1;
-            g_bullets[i].x = g_ship.x + SHIP_SIZE / 2.0f * cosf(g_ship.angle * M_PI / 180.0f);
-            g_bullets[i].y = g_ship.y + SHIP_SIZE / 2.0f * sinf(g_ship.angle * M_PI / 180.0f);
-            g_bullets[i].vx = g_ship.vx + BULLET_SPEED * cosf(g_ship.angle * M_PI / 180.0f);
-            g_bullets[i].vy = g_ship.vy + BULLET_SPEED * sinf(g_ship.angle * M_PI / 180.0f);
-            g_bullets[i].lifetime = 60;
-            if(g_shoot_sound) Mix_PlayChannel(-1, g_shoot_sound, 0);
-            return;
+// Swap-with-last compaction of asteroids marked dead this tick. Deferred to
+// the end of the tick so grid indices stay valid through the collision pass.
+void compact_asteroids() {
+    for (int i = 0; i < g_asteroid_count; ) {
+        if (!g_asteroid_dead[i]) { i++; continue; }
+        int last = --g_asteroid_count;
+        if (i != last) {
+            g_asteroid_x[i] = g_asteroid_x[last];
+            g_asteroid_y[i] = g_asteroid_y[last];
+            g_asteroid_prev_x[i] = g_asteroid_prev_x[last];
+            g_asteroid_prev_y[i] = g_asteroid_prev_y[last];
+            g_asteroid_vx[i] = g_asteroid_vx[last];
+            g_asteroid_vy[i] = g_asteroid_vy[last];
+            g_asteroid_angle[i] = g_asteroid_angle[last];
+            g_asteroid_rot_speed[i] = g_asteroid_rot_speed[last];
+            g_asteroid_size[i] = g_asteroid_size[last];
+            g_asteroid_radius[i] = g_asteroid_radius[last];
+            g_asteroid_dead[i] = g_asteroid_dead[last];
+            g_asteroid_shape[i] = g_asteroid_shape[last];
+            g_asteroid_rot_step[i] = g_asteroid_rot_step[last];
+            g_asteroid_visible[i] = g_asteroid_visible[last];
+            memcpy(g_asteroid_rotated[i], g_asteroid_rotated[last], sizeof(g_asteroid_rotated[i]));
         }
     }
 }
 
+// Scatters debris from (x, y) in random directions. Directions come from
+// the quantized sin/cos table, so bursts cost no libm calls.
+// The rand() draws happen for every requested particle, even ones the
+// governor sheds or a full pool drops, so the simulation RNG stream is
+// identical at every quality level and on both lockstep peers.
+void spawn_particles(float x, float y, int count, float max_speed) {
+    int shed_mask = (1 << g_gov_particle_shift) - 1;
+    for (int n = 0; n < count; n++) {
+        int step = rand() & (ROT_STEPS - 1);
+        float speed = max_speed * ((rand() % 100) + 1) / 100.0f;
+        int life = PARTICLE_LIFETIME / 2 + rand() % (PARTICLE_LIFETIME / 2);
+        if (n & shed_mask) continue; // governor shedding spawn rate
+        if (g_particle_count >= MAX_PARTICLES) continue;
+        int i = g_particle_count++;
+        g_particle_x[i] = x;
+        g_particle_y[i] = y;
+        g_particle_prev_x[i] = x;
+        g_particle_prev_y[i] = y;
+        g_particle_vx[i] = g_cos_table[step] * speed;
+        g_particle_vy[i] = g_sin_table[step] * speed;
+        g_particle_life[i] = life;
+    }
+}
+
+void update_particles() {
+    run_parallel(job_integrate_particles, g_particle_count);
+    for (int i = 0; i < g_particle_count; ) {
+        if (--g_particle_life[i] <= 0) {
+            int last = --g_particle_count;
+            g_particle_x[i] = g_particle_x[last];
+            g_particle_y[i] = g_particle_y[last];
+            g_particle_prev_x[i] = g_particle_prev_x[last];
+            g_particle_prev_y[i] = g_particle_prev_y[last];
+            g_particle_vx[i] = g_particle_vx[last];
+            g_particle_vy[i] = g_particle_vy[last];
+            g_particle_life[i] = g_particle_life[last];
+        } else {
+            i++;
+        }
+    }
+}
+
+void fire_bullet(Ship* ship) {
+    if (!ship->alive) return;
+    if (g_bullet_count >= MAX_BULLETS) return;
+    int i = g_bullet_count++;
+    g_bullet_x[i] = ship->x + SHIP_SIZE / 2.0f * cosf(ship->angle * M_PI / 180.0f);
+    g_bullet_y[i] = ship->y + SHIP_SIZE / 2.0f * sinf(ship->angle * M_PI / 180.0f);
+    g_bullet_prev_x[i] = g_bullet_x[i];
+    g_bullet_prev_y[i] = g_bullet_y[i];
+    g_bullet_vx[i] = ship->vx + BULLET_SPEED * cosf(ship->angle * M_PI / 180.0f);
+    g_bullet_vy[i] = ship->vy + BULLET_SPEED * sinf(ship->angle * M_PI / 180.0f);
+    g_bullet_lifetime[i] = 60;
+    queue_sound(g_shoot_sound, -1, 0);
+}
+
 void handle_input(int* is_running) {
     SDL_Event e;
     while (SDL_PollEvent(&e) != 0) {
         if (e.type == SDL_QUIT) *is_running = 0;
+        if (e.type == SDL_KEYDOWN && e.key.keysym.scancode == SDL_SCANCODE_F1 && !e.key.repeat) {
+            g_show_profiler = !g_show_profiler;
+        }
+        if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+            update_render_scale();
+            g_incremental_valid = 0; // stale letterbox after resize
+        }
+        if (e.type == SDL_KEYDOWN && e.key.keysym.scancode == SDL_SCANCODE_F3 && !e.key.repeat) {
+            g_autoplay = !g_autoplay;
+        }
+        if (e.type == SDL_KEYDOWN && e.key.keysym.scancode == SDL_SCANCODE_F2 && !e.key.repeat) {
+            g_incremental_mode = !g_incremental_mode;
+            g_incremental_valid = 0; // force one full clear on switch
+        }
+        if (e.type == SDL_KEYDOWN && e.key.keysym.scancode == SDL_SCANCODE_RETURN &&
+            !e.key.repeat && g_game_over && !g_net_mode) {
+            reset_game();
+        }
+        // Save-states for the tournament setup: F5 captures, F9 restores.
+        // Restart and save-states are disabled in lockstep co-op: they
+        // would rewrite one cabinet's state outside the input protocol,
+        // and nothing would ever detect or repair the fork (resync only
+        // fires on input stalls, not on divergence).
+        if (e.type == SDL_KEYDOWN && e.key.keysym.scancode == SDL_SCANCODE_F5 &&
+            !e.key.repeat && !g_net_mode) {
+            snapshot_save();
+        }
+        if (e.type == SDL_KEYDOWN && e.key.keysym.scancode == SDL_SCANCODE_F9 &&
+            !e.key.repeat && !g_net_mode) {
+            snapshot_restore();
+        }
     }
-    if (!g_ship.alive) return;
+}
 
+unsigned read_keyboard_input() {
     const Uint8* state = SDL_GetKeyboardState(NULL);
-    if (state[SDL_SCANCODE_LEFT]) g_ship.angle -= SHIP_TURN_SPEED;
-    if (state[SDL_SCANCODE_RIGHT]) g_ship.angle += SHIP_TURN_SPEED;
-    if (state[SDL_SCANCODE_UP]) {
-        g_ship.vx += SHIP_ACCELERATION * cosf(g_ship.angle * M_PI / 180.0f);
-        g_ship.vy += SHIP_ACCELERATION * sinf(g_ship.angle * M_PI / 180.0f);
-        if (g_thrust_sound && !Mix_Playing(1)) {
-            Mix_PlayChannel(1, g_thrust_sound, -1);
+    unsigned input = 0;
+    if (state[SDL_SCANCODE_LEFT]) input |= INPUT_LEFT;
+    if (state[SDL_SCANCODE_RIGHT]) input |= INPUT_RIGHT;
+    if (state[SDL_SCANCODE_UP]) input |= INPUT_THRUST;
+    if (state[SDL_SCANCODE_SPACE]) input |= INPUT_FIRE;
+    return input;
+}
+
+// Attract-mode pilot. Targeting walks grid cells in expanding rings
+// around the ship (the grid is one tick stale, which the aim tolerance
+// absorbs) and keeps the nearest torus-wrapped asteroid; the walk ends
+// one ring after the first hit so a neighbour just across a cell seam
+// still wins. Between retargets the cached index is only sanity-checked
+// against the dense count -- compaction may have swapped another
+// asteroid into it, which merely means we shoot that one instead.
+unsigned autoplay_input() {
+    if (!g_ship.alive) return 0;
+
+    if (--g_ai_retarget <= 0 || g_ai_target >= g_asteroid_count) {
+        g_ai_retarget = AI_RETARGET_TICKS;
+        g_ai_target = -1;
+        int ship_col = (int)(g_ship.x / GRID_CELL_SIZE);
+        int ship_row = (int)(g_ship.y / GRID_CELL_SIZE);
+        float best_d2 = 1e30f;
+        int stop_ring = AI_MAX_RING;
+        for (int r = 0; r <= stop_ring && r <= AI_MAX_RING; r++) {
+            for (int dr = -r; dr <= r; dr++) {
+                for (int dc = -r; dc <= r; dc++) {
+                    if (r > 0 && dr > -r && dr < r && dc > -r && dc < r) continue; // ring perimeter only
+                    int col = (ship_col + dc + GRID_COLS) % GRID_COLS;
+                    int row = (ship_row + dr + GRID_ROWS) % GRID_ROWS;
+                    for (int i = g_grid_head[row * GRID_COLS + col]; i != -1; i = g_grid_next[i]) {
+                        float dx = g_asteroid_x[i] - g_ship.x;
+                        float dy = g_asteroid_y[i] - g_ship.y;
+                        if (dx > WORLD_WIDTH * 0.5f) dx -= WORLD_WIDTH;
+                        if (dx < -WORLD_WIDTH * 0.5f) dx += WORLD_WIDTH;
+                        if (dy > WORLD_HEIGHT * 0.5f) dy -= WORLD_HEIGHT;
+                        if (dy < -WORLD_HEIGHT * 0.5f) dy += WORLD_HEIGHT;
+                        float d2 = dx * dx + dy * dy;
+                        if (d2 < best_d2) {
+                            best_d2 = d2;
+                            g_ai_target = i;
+                        }
+                    }
+                }
+            }
+            if (g_ai_target != -1 && stop_ring == AI_MAX_RING) stop_ring = r + 1;
         }
-    } else {
-        Mix_HaltChannel(1);
     }
-    if (state[SDL_SCANCODE_SPACE]) {
-        static Uint32 last_shot = 0;
-        if (SDL_GetTicks() - last_shot > 200) {
-            fire_bullet();
-            last_shot = SDL_GetTicks();
+    if (g_ai_target < 0 || g_ai_target >= g_asteroid_count) return 0;
+
+    // Lead the shot: aim where the target will be when a bullet covers
+    // the current separation, not where it is now.
+    int t = g_ai_target;
+    float dx = g_asteroid_x[t] - g_ship.x;
+    float dy = g_asteroid_y[t] - g_ship.y;
+    if (dx > WORLD_WIDTH * 0.5f) dx -= WORLD_WIDTH;
+    if (dx < -WORLD_WIDTH * 0.5f) dx += WORLD_WIDTH;
+    if (dy > WORLD_HEIGHT * 0.5f) dy -= WORLD_HEIGHT;
+    if (dy < -WORLD_HEIGHT * 0.5f) dy += WORLD_HEIGHT;
+    float dist = sqrtf(dx * dx + dy * dy);
+    float lead = dist / BULLET_SPEED;
+    dx += g_asteroid_vx[t] * lead;
+    dy += g_asteroid_vy[t] * lead;
+
+    float desired = atan2f(dy, dx) * 180.0f / (float)M_PI;
+    float diff = desired - g_ship.angle;
+    while (diff > 180.0f) diff -= 360.0f;
+    while (diff < -180.0f) diff += 360.0f;
+
+    unsigned input = 0;
+    if (diff > AI_AIM_TOLERANCE) input |= INPUT_RIGHT;
+    else if (diff < -AI_AIM_TOLERANCE) input |= INPUT_LEFT;
+    if (diff > -2.0f * AI_AIM_TOLERANCE && diff < 2.0f * AI_AIM_TOLERANCE) input |= INPUT_FIRE;
+    // Thrust-avoid: back away when the threat is close and roughly
+    // behind us; otherwise drift and let the guns do the work.
+    if (dist < AI_DANGER_RADIUS && (diff > 120.0f || diff < -120.0f)) input |= INPUT_THRUST;
+    return input;
+}
+
+// Runs once per simulation tick (not per frame) so turn/thrust rates do
+// not depend on how fast the display is refreshing. Takes an input
+// bitmask rather than reading the keyboard so scripted input (headless
+// benchmarks) goes through the identical path.
+void apply_ship_controls(unsigned input) {
+    apply_controls(&g_ship, &g_fire_cooldown, input, 1);
+}
+
+// Per-ship control body shared by both players. The thrust-sound
+// start/stop only runs for the local ship (local_sound) -- audio is
+// cosmetic and per-cabinet, so this cannot affect lockstep.
+void apply_controls(Ship* ship, int* cooldown, unsigned input, int local_sound) {
+    if (*cooldown > 0) (*cooldown)--;
+    if (!ship->alive) return;
+
+    if (input & INPUT_LEFT) ship->angle -= SHIP_TURN_SPEED;
+    if (input & INPUT_RIGHT) ship->angle += SHIP_TURN_SPEED;
+    if (input & INPUT_THRUST) {
+        float heading = ship->angle * M_PI / 180.0f;
+        ship->vx += SHIP_ACCELERATION * cosf(heading);
+        ship->vy += SHIP_ACCELERATION * sinf(heading);
+        // Exhaust puffs trail out of the back of the ship
+        spawn_particles(ship->x - cosf(heading) * SHIP_SIZE * 0.6f,
+                        ship->y - sinf(heading) * SHIP_SIZE * 0.6f, 2, 1.5f);
+        if (local_sound && g_thrust_sound && !g_thrust_playing) {
+            queue_sound(g_thrust_sound, 1, -1);
+            g_thrust_playing = 1;
+        }
+    } else if (local_sound && g_thrust_playing) {
+        queue_halt(1);
+        g_thrust_playing = 0;
+    }
+    if ((input & INPUT_FIRE) && *cooldown == 0) {
+        fire_bullet(ship);
+        *cooldown = FIRE_COOLDOWN_TICKS;
+    }
+}
+
+void update_ship(Ship* ship) {
+    if (!ship->alive) return;
+    ship->x += ship->vx;
+    ship->y += ship->vy;
+    ship->vx *= SHIP_FRICTION;
+    ship->vy *= SHIP_FRICTION;
+    wrap_coordinates(&ship->x, &ship->y);
+    if (ship->invincible_timer > 0) ship->invincible_timer--;
+}
+
+// Grid-assisted ship/asteroid test; death draws from the shared life
+// pool, so in co-op either pilot can burn the team's lives.
+void ship_asteroid_collision(Ship* ship) {
+    if (!ship->alive || ship->invincible_timer > 0) return;
+    int min_col, max_col, min_row, max_row;
+    grid_cell_range(ship->x, ship->y, SHIP_SIZE / 2.0f, &min_col, &max_col, &min_row, &max_row);
+    int hit = 0;
+    for (int row = min_row; row <= max_row && !hit; row++) {
+        int wrow = (row + GRID_ROWS) % GRID_ROWS;
+        for (int col = min_col; col <= max_col && !hit; col++) {
+            int wcol = (col + GRID_COLS) % GRID_COLS;
+            for (int i = g_grid_head[wrow * GRID_COLS + wcol]; i != -1; i = g_grid_next[i]) {
+                if (g_asteroid_dead[i]) continue;
+                float dist = hypotf(ship->x - g_asteroid_x[i], ship->y - g_asteroid_y[i]);
+                if (dist < g_asteroid_size[i] * 8 + SHIP_SIZE / 2.0f) { hit = 1; break; }
+            }
+        }
+    }
+    if (hit) {
+        ship->alive = 0;
+        spawn_particles(ship->x, ship->y, 40, 3.0f);
+        queue_sound(g_bang_large_sound, -1, 0);
+        g_lives--;
+        if(g_lives <= 0) {
+            g_game_over = 1;
+        } else {
+            ship->x = WORLD_WIDTH/2.0f; ship->y = WORLD_HEIGHT/2.0f;
+            ship->prev_x = ship->x; ship->prev_y = ship->y;
+            ship->vx = 0; ship->vy = 0; ship->angle = -90.0f;
+            ship->alive = 1;
+            ship->invincible_timer = RESPAWN_INVINCIBILITY;
         }
     }
 }
 
 void wrap_coordinates(float* x, float* y) {
-    if (*x < 0) *x += SCREEN_WIDTH;
-    if (*x > SCREEN_WIDTH) *x -= SCREEN_WIDTH;
-    if (*y < 0) *y += SCREEN_HEIGHT;
-    if (*y > SCREEN_HEIGHT) *y -= SCREEN_HEIGHT;
+    if (*x < 0) *x += WORLD_WIDTH;
+    if (*x > WORLD_WIDTH) *x -= WORLD_WIDTH;
+    if (*y < 0) *y += WORLD_HEIGHT;
+    if (*y > WORLD_HEIGHT) *y -= WORLD_HEIGHT;
+}
+
+// Integrates whole position arrays and wraps them onto the torus in one
+// pass. The wrap is branchless: (nx < 0) - (nx > W) is -1, 0 or +1, so the
+// multiply-add is equivalent to the two ifs in wrap_coordinates() but
+// compiles to SSE compares and blends. GCC auto-vectorizes this loop with
+// the -ftree-vectorize the Makefile now passes (verified via
+// -fopt-info-vec); the ternary form is rejected as "control flow in loop".
+void integrate_and_wrap(int count, float* restrict x, float* restrict y,
+                        const float* restrict vx, const float* restrict vy) {
+    for (int i = 0; i < count; i++) {
+        float nx = x[i] + vx[i];
+        float ny = y[i] + vy[i];
+        nx += (float)WORLD_WIDTH * ((nx < 0.0f) - (nx > (float)WORLD_WIDTH));
+        ny += (float)WORLD_HEIGHT * ((ny < 0.0f) - (ny > (float)WORLD_HEIGHT));
+        x[i] = nx;
+        y[i] = ny;
+    }
+}
+
+void grid_rebuild() {
+    run_parallel(job_bin_asteroids, g_asteroid_count);
+    for (int i = 0; i < GRID_COLS * GRID_ROWS; i++) g_grid_head[i] = -1;
+    for (int i = 0; i < g_asteroid_count; i++) {
+        g_grid_next[i] = g_grid_head[g_asteroid_cell[i]];
+        g_grid_head[g_asteroid_cell[i]] = i;
+    }
+}
+
+// Computes the cell range a circle query must visit, padded by the
+// largest asteroid radius since asteroids are binned by center. The
+// range is deliberately NOT clamped to the world: indices may run past
+// either edge, and callers wrap them with a modulo (like the AI's ring
+// walk does) so a query hugging the torus seam still sees candidates
+// binned on the far side. The span is capped at one full lap. Returns
+// the number of cells in the range.
+int grid_cell_range(float x, float y, float radius, int* min_col, int* max_col, int* min_row, int* max_row) {
+    float reach = radius + ASTEROID_MAX_RADIUS;
+    *min_col = (int)floorf((x - reach) / GRID_CELL_SIZE);
+    *max_col = (int)floorf((x + reach) / GRID_CELL_SIZE);
+    *min_row = (int)floorf((y - reach) / GRID_CELL_SIZE);
+    *max_row = (int)floorf((y + reach) / GRID_CELL_SIZE);
+    if (*max_col - *min_col >= GRID_COLS) *max_col = *min_col + GRID_COLS - 1;
+    if (*max_row - *min_row >= GRID_ROWS) *max_row = *min_row + GRID_ROWS - 1;
+    return (*max_col - *min_col + 1) * (*max_row - *min_row + 1);
+}
+
+// Swept segment-vs-circle: intersects the segment P + t*D, t in [0,1],
+// with a circle of radius r centered at the origin (the caller works in
+// the circle's frame). Returns 1 with the clamped entry/exit times when
+// any part of the segment is inside; degenerate segments fall back to a
+// point test at P.
+int sweep_circle(float px, float py, float dx, float dy, float r, float* t_in, float* t_out) {
+    float a = dx * dx + dy * dy;
+    float c = px * px + py * py - r * r;
+    if (a < 1e-12f) {
+        if (c > 0.0f) return 0;
+        *t_in = 0.0f;
+        *t_out = 0.0f;
+        return 1;
+    }
+    float b = px * dx + py * dy; // half-b form: t = (-b +/- sqrt(b*b - a*c)) / a
+    float disc = b * b - a * c;
+    if (disc < 0.0f) return 0;
+    float root = sqrtf(disc);
+    float t0 = (-b - root) / a;
+    float t1 = (-b + root) / a;
+    if (t1 < 0.0f || t0 > 1.0f) return 0; // circle entirely behind or ahead
+    *t_in = t0 < 0.0f ? 0.0f : t0;
+    *t_out = t1 > 1.0f ? 1.0f : t1;
+    return 1;
+}
+
+// Exact narrow-phase test: translates the point into the asteroid's
+// model space, un-rotates it via the quantized angle table, then runs an
+// even-odd crossing test against the polygon outline. Only called on the
+// few candidates that survive the bounding-radius filter.
+int point_in_asteroid(int i, float px, float py) {
+    float dx = px - g_asteroid_x[i];
+    float dy = py - g_asteroid_y[i];
+    int step = rot_step_for_angle(g_asteroid_angle[i]);
+    float c = g_cos_table[step], sn = g_sin_table[step];
+    float mx = dx * c + dy * sn;
+    float my = -dx * sn + dy * c;
+    int n = g_shape_num_vertices[g_asteroid_size[i]-1][g_asteroid_shape[i]];
+    const float* v = g_shape_vertices[g_asteroid_size[i]-1][g_asteroid_shape[i]];
+    int inside = 0;
+    for (int j = 0, k = n - 1; j < n; k = j++) {
+        float xj = v[j*2], yj = v[j*2+1];
+        float xk = v[k*2], yk = v[k*2+1];
+        if ((yj > my) != (yk > my) &&
+            mx < (xk - xj) * (my - yj) / (yk - yj) + xj) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+// --- Parallel job bodies (disjoint ranges, no shared writes) ---
+void job_integrate_asteroids(int start, int end) {
+    integrate_and_wrap(end - start, g_asteroid_x + start, g_asteroid_y + start,
+                       g_asteroid_vx + start, g_asteroid_vy + start);
+    for (int i = start; i < end; i++) {
+        g_asteroid_angle[i] += g_asteroid_rot_speed[i];
+    }
+    // Classify against the view rect grown by the max radius, in the
+    // same branchless compare style as the wrap above so the loop
+    // stays vectorizable.
+    float min_x = g_view_min_x - ASTEROID_MAX_RADIUS;
+    float min_y = g_view_min_y - ASTEROID_MAX_RADIUS;
+    float max_x = g_view_max_x + ASTEROID_MAX_RADIUS;
+    float max_y = g_view_max_y + ASTEROID_MAX_RADIUS;
+    for (int i = start; i < end; i++) {
+        g_asteroid_visible[i] = (Uint8)((g_asteroid_x[i] >= min_x) & (g_asteroid_x[i] <= max_x) &
+                                        (g_asteroid_y[i] >= min_y) & (g_asteroid_y[i] <= max_y));
+    }
+}
+
+void job_integrate_particles(int start, int end) {
+    integrate_and_wrap(end - start, g_particle_x + start, g_particle_y + start,
+                       g_particle_vx + start, g_particle_vy + start);
+}
+
+void job_bin_asteroids(int start, int end) {
+    for (int i = start; i < end; i++) {
+        int col = (int)(g_asteroid_x[i] / GRID_CELL_SIZE);
+        int row = (int)(g_asteroid_y[i] / GRID_CELL_SIZE);
+        if (col < 0) col = 0;
+        if (col >= GRID_COLS) col = GRID_COLS - 1;
+        if (row < 0) row = 0;
+        if (row >= GRID_ROWS) row = GRID_ROWS - 1;
+        g_asteroid_cell[i] = row * GRID_COLS + col;
+    }
 }
 
 void update_game() {
-    // Update ship
-    if (g_ship.alive) {
-        g_ship.x += g_ship.vx;
-        g_ship.y += g_ship.vy;
-        g_ship.vx *= SHIP_FRICTION;
-        g_ship.vy *= SHIP_FRICTION;
-        wrap_coordinates(&g_ship.x, &g_ship.y);
-        if (g_ship.invincible_timer > 0) {
-            g_ship.invincible_timer--;
-        }
-    }
-
-    // Update bullets
-    for (int i = 0; i < MAX_BULLETS; i++) {
-        if (g_bullets[i].active) {
-            g_bullets[i].x += g_bullets[i].vx;
-            g_bullets[i].y += g_bullets[i].vy;
-            wrap_coordinates(&g_bullets[i].x, &g_bullets[i].y);
-            if (--g_bullets[i].lifetime <= 0) g_bullets[i].active = 0;
-        }
-    }
-
-    // Update asteroids and check collisions
-    int asteroids_count = 0;
-    for (int i = 0; i < MAX_ASTEROIDS; i++) {
-        if (g_asteroids[i].alive) {
-            asteroids_count++;
-            g_asteroids[i].x += g_asteroids[i].vx;
-            g_asteroids[i].y += g_asteroids[i].vy;
-            g_asteroids[i].angle += g_asteroids[i].rotation_speed;
-            wrap_coordinates(&g_asteroids[i].x, &g_asteroids[i].y);
-            
-            // Bullet-Asteroid collision
-            for (int j = 0; j < MAX_BULLETS; j++) {
-                if (g_bullets[j].active) {
-                    float dist = hypotf(g_bullets[j].x - g_asteroids[i].x, g_bullets[j].y - g_asteroids[i].y);
-                    if (dist < g_asteroids[i].size * 10) {
-                        g_asteroids[i].alive = 0;
-                        g_bullets[j].active = 0;
-                        if (g_asteroids[i].size > 1) {
-                            spawn_asteroid(g_asteroids[i].x, g_asteroids[i].y, g_asteroids[i].size - 1);
-                            spawn_asteroid(g_asteroids[i].x, g_asteroids[i].y, g_asteroids[i].size - 1);
+    Uint64 t0 = SDL_GetPerformanceCounter();
+
+    // Remember where everything was so the renderer can interpolate
+    // between this tick and the last one.
+    g_ship.prev_x = g_ship.x;
+    g_ship.prev_y = g_ship.y;
+    g_ship2.prev_x = g_ship2.x;
+    g_ship2.prev_y = g_ship2.y;
+    memcpy(g_bullet_prev_x, g_bullet_x, g_bullet_count * sizeof(float));
+    memcpy(g_bullet_prev_y, g_bullet_y, g_bullet_count * sizeof(float));
+    memcpy(g_asteroid_prev_x, g_asteroid_x, g_asteroid_count * sizeof(float));
+    memcpy(g_asteroid_prev_y, g_asteroid_y, g_asteroid_count * sizeof(float));
+    memcpy(g_particle_prev_x, g_particle_x, g_particle_count * sizeof(float));
+    memcpy(g_particle_prev_y, g_particle_y, g_particle_count * sizeof(float));
+
+    // Update ships
+    update_ship(&g_ship);
+    if (g_net_mode) update_ship(&g_ship2);
+
+    // Update bullets: vectorized integrate/wrap, then a scalar expiry pass
+    integrate_and_wrap(g_bullet_count, g_bullet_x, g_bullet_y, g_bullet_vx, g_bullet_vy);
+    for (int i = 0; i < g_bullet_count; ) {
+        if (--g_bullet_lifetime[i] <= 0) {
+            int last = --g_bullet_count;
+            g_bullet_x[i] = g_bullet_x[last];
+            g_bullet_y[i] = g_bullet_y[last];
+            g_bullet_prev_x[i] = g_bullet_prev_x[last];
+            g_bullet_prev_y[i] = g_bullet_prev_y[last];
+            g_bullet_vx[i] = g_bullet_vx[last];
+            g_bullet_vy[i] = g_bullet_vy[last];
+            g_bullet_lifetime[i] = g_bullet_lifetime[last];
+        } else {
+            i++;
+        }
+    }
+
+    // Update asteroids (integration fans out across the worker pool)
+    run_parallel(job_integrate_asteroids, g_asteroid_count);
+
+    update_particles();
+
+    prof_record(PROF_INTEGRATE, SDL_GetPerformanceCounter() - t0);
+    t0 = SDL_GetPerformanceCounter();
+
+    // Re-bin the moved asteroids, then run collisions as local grid queries
+    // instead of scanning the whole asteroid array per bullet.
+    grid_rebuild();
+
+    // Bullet-Asteroid collision, swept over each bullet's prev->current
+    // segment so a fast bullet can't tunnel through a small asteroid
+    // between ticks. Only asteroids that existed at grid_rebuild() are
+    // candidates; splits spawned below join the grid next tick.
+    for (int j = 0; j < g_bullet_count; ) {
+        int bullet_hit = 0;
+        // Segment delta with the torus seam unwrapped (same trick as
+        // lerp_wrapped): a bullet that wrapped this tick still sweeps a
+        // short segment, not one spanning the whole world.
+        float sdx = g_bullet_x[j] - g_bullet_prev_x[j];
+        float sdy = g_bullet_y[j] - g_bullet_prev_y[j];
+        sdx -= (float)WORLD_WIDTH * ((sdx > WORLD_WIDTH * 0.5f) - (sdx < -WORLD_WIDTH * 0.5f));
+        sdy -= (float)WORLD_HEIGHT * ((sdy > WORLD_HEIGHT * 0.5f) - (sdy < -WORLD_HEIGHT * 0.5f));
+        float seg_len = sqrtf(sdx * sdx + sdy * sdy);
+        int min_col, max_col, min_row, max_row;
+        // Padding the point query by the segment length covers every
+        // cell the segment crosses; at ~10 px of travel per tick this
+        // visits the same 2x2-ish neighbourhood as the old point test.
+        grid_cell_range(g_bullet_x[j], g_bullet_y[j], seg_len, &min_col, &max_col, &min_row, &max_row);
+        for (int row = min_row; row <= max_row && !bullet_hit; row++) {
+            int wrow = (row + GRID_ROWS) % GRID_ROWS;
+            for (int col = min_col; col <= max_col && !bullet_hit; col++) {
+                int wcol = (col + GRID_COLS) % GRID_COLS;
+                for (int i = g_grid_head[wrow * GRID_COLS + wcol]; i != -1; i = g_grid_next[i]) {
+                    if (g_asteroid_dead[i]) continue; // killed earlier this tick, still binned
+                    // Segment start relative to the asteroid, wrapped
+                    // into the nearest image so the sweep runs in plain
+                    // euclidean space.
+                    float rx = g_bullet_prev_x[j] - g_asteroid_x[i];
+                    float ry = g_bullet_prev_y[j] - g_asteroid_y[i];
+                    rx -= (float)WORLD_WIDTH * ((rx > WORLD_WIDTH * 0.5f) - (rx < -WORLD_WIDTH * 0.5f));
+                    ry -= (float)WORLD_HEIGHT * ((ry > WORLD_HEIGHT * 0.5f) - (ry < -WORLD_HEIGHT * 0.5f));
+                    float t_in, t_out;
+                    if (!sweep_circle(rx, ry, sdx, sdy, g_asteroid_radius[i], &t_in, &t_out))
+                        continue;
+                    // Walk the in-circle span of the segment in ~2 px
+                    // steps through the exact polygon test; the bounding
+                    // circle overhangs the outline, so the entry point
+                    // alone isn't proof of a hit.
+                    int steps = (int)((t_out - t_in) * seg_len * 0.5f) + 1;
+                    int inside = 0;
+                    for (int s = 0; s <= steps && !inside; s++) {
+                        float t = t_in + (t_out - t_in) * (float)s / steps;
+                        inside = point_in_asteroid(i, g_asteroid_x[i] + rx + t * sdx,
+                                                      g_asteroid_y[i] + ry + t * sdy);
+                    }
+                    if (inside) {
+                        g_asteroid_dead[i] = 1;
+                        bullet_hit = 1;
+                        if (g_asteroid_size[i] > 1 && g_split_count + 2 <= MAX_SPLIT_EVENTS) {
+                            g_split_queue[g_split_count++] = (SplitEvent){g_asteroid_x[i], g_asteroid_y[i], g_asteroid_size[i] - 1};
+                            g_split_queue[g_split_count++] = (SplitEvent){g_asteroid_x[i], g_asteroid_y[i], g_asteroid_size[i] - 1};
                         }
-                        if (g_asteroids[i].size == 3 && g_bang_large_sound) Mix_PlayChannel(-1, g_bang_large_sound, 0);
-                        else if (g_asteroids[i].size == 2 && g_bang_medium_sound) Mix_PlayChannel(-1, g_bang_medium_sound, 0);
-                        else if(g_bang_small_sound) Mix_PlayChannel(-1, g_bang_small_sound, 0);
+                        spawn_particles(g_asteroid_x[i], g_asteroid_y[i], g_asteroid_size[i] * 8, 2.5f);
+                        // Pitch step comes from the impact position, not
+                        // rand(), so the simulation RNG stream (and with
+                        // it replay determinism) is untouched.
+                        int pitch = ((int)g_asteroid_x[i] ^ (int)g_asteroid_y[i]) & (PITCH_STEPS - 1);
+                        record_kill(3 - g_asteroid_size[i], pitch);
 
-                        g_score += (4 - g_asteroids[i].size) * 20;
+                        g_score += (4 - g_asteroid_size[i]) * 20;
                         break;
                     }
                 }
             }
-            // Player-Asteroid collision (only if not invincible)
-            float dist = hypotf(g_ship.x - g_asteroids[i].x, g_ship.y - g_asteroids[i].y);
-            if (g_ship.alive && g_ship.invincible_timer <= 0 && dist < g_asteroids[i].size * 8 + SHIP_SIZE / 2.0f) {
-                g_ship.alive = 0; 
-                if(g_bang_large_sound) Mix_PlayChannel(-1, g_bang_large_sound, 0);
-                g_lives--;
-                if(g_lives <= 0) { 
-                    g_game_over = 1; 
-                } else {
-                    g_ship.x = SCREEN_WIDTH/2.0f; g_ship.y = SCREEN_HEIGHT/2.0f;
-                    g_ship.vx = 0; g_ship.vy = 0; g_ship.angle = -90.0f;
-                    g_ship.alive = 1;
-                    g_ship.invincible_timer = RESPAWN_INVINCIBILITY;
-                }
-            }
         }
+        if (bullet_hit) {
+            int last = --g_bullet_count;
+            g_bullet_x[j] = g_bullet_x[last];
+            g_bullet_y[j] = g_bullet_y[last];
+            g_bullet_prev_x[j] = g_bullet_prev_x[last];
+            g_bullet_prev_y[j] = g_bullet_prev_y[last];
+            g_bullet_vx[j] = g_bullet_vx[last];
+            g_bullet_vy[j] = g_bullet_vy[last];
+            g_bullet_lifetime[j] = g_bullet_lifetime[last];
+        } else {
+            j++;
+        }
+    }
+
+    // Player-Asteroid collision (only if not invincible)
+    ship_asteroid_collision(&g_ship);
+    if (g_net_mode) ship_asteroid_collision(&g_ship2);
+
+    // All kills for this tick are tallied; collapse them into at most
+    // one play per size class before the ring sees anything.
+    flush_kill_sounds();
+    prof_record(PROF_COLLIDE, SDL_GetPerformanceCounter() - t0);
+    t0 = SDL_GetPerformanceCounter();
+
+    // Drain the split queue now that the collision pass is done
+    for (int e = 0; e < g_split_count; e++) {
+        spawn_asteroid(g_split_queue[e].x, g_split_queue[e].y, g_split_queue[e].size);
     }
-    if (asteroids_count == 0 && !g_game_over) {
+    g_split_count = 0;
+
+    compact_asteroids();
+
+    g_session_ticks++;
+    if ((Uint32)g_asteroid_count > g_session_peak_asteroids)
+        g_session_peak_asteroids = (Uint32)g_asteroid_count;
+    if (g_score > g_high_score) g_high_score = g_score;
+
+    if (g_asteroid_count == 0 && !g_game_over) {
+        queue_telemetry(0);
         g_level++;
         setup_level();
     }
+    prof_record(PROF_SPAWN, SDL_GetPerformanceCounter() - t0);
 }
 
-void render_game() {
-    SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 255);
-    SDL_RenderClear(g_renderer);
-    SDL_SetRenderDrawColor(g_renderer, 255, 255, 255, 255);
-    
-    // Draw score and lives
-    draw_number(g_score, 10, 5);
-    for(int i=0; i<g_lives; i++) {
-        SDL_Point ship_points[] = {
-            {(int)(SCREEN_WIDTH - 30 - i*30), 10},
-            {(int)(SCREEN_WIDTH - 50 - i*30), 30},
-            {(int)(SCREEN_WIDTH - 40 - i*30), 25},
-            {(int)(SCREEN_WIDTH - 30 - i*30), 30},
-            {(int)(SCREEN_WIDTH - 30 - i*30), 10}
-        };
-        SDL_RenderDrawLines(g_renderer, ship_points, 5);
+// Deterministic pilot for benchmark runs: fires constantly, sweeps the
+// turn direction and thrusts in bursts so the field keeps churning.
+unsigned scripted_input(int tick) {
+    unsigned input = INPUT_FIRE;
+    if ((tick / 120) % 2 == 0) input |= INPUT_LEFT;
+    else input |= INPUT_RIGHT;
+    if ((tick / 45) % 3 == 0) input |= INPUT_THRUST;
+    return input;
+}
+
+int compare_u64(const void* a, const void* b) {
+    Uint64 ua = *(const Uint64*)a, ub = *(const Uint64*)b;
+    return (ua > ub) - (ua < ub);
+}
+
+// Runs N simulation ticks back-to-back with scripted input and reports
+// tick-rate and per-tick latency statistics. Rendering, audio and vsync
+// are never touched, so the numbers isolate simulation cost.
+int run_headless(int ticks) {
+    if (ticks <= 0) {
+        fprintf(stderr, "--headless requires a positive tick count\n");
+        return 1;
     }
+    Uint64* samples = malloc((size_t)ticks * sizeof(Uint64));
+    if (!samples) return 1;
 
+    double freq = (double)SDL_GetPerformanceFrequency();
+    int peak_asteroids = 0, peak_bullets = 0, restarts = 0;
+    Uint64 bench_start = SDL_GetPerformanceCounter();
+    for (int t = 0; t < ticks; t++) {
+        Uint64 t0 = SDL_GetPerformanceCounter();
+        apply_ship_controls(next_tick_input(scripted_input(t)));
+        update_game();
+        samples[t] = SDL_GetPerformanceCounter() - t0;
+        if (g_asteroid_count > peak_asteroids) peak_asteroids = g_asteroid_count;
+        if (g_bullet_count > peak_bullets) peak_bullets = g_bullet_count;
+        if (g_game_over) {
+            // Keep the benchmark churning through ship deaths.
+            reset_game();
+            restarts++;
+        }
+    }
+    double total_s = (double)(SDL_GetPerformanceCounter() - bench_start) / freq;
 
-    // Draw ship (and blink if invincible)
-    if (g_ship.alive && !(g_ship.invincible_timer > 0 && (g_ship.invincible_timer / 10) % 2 == 0)) {
-        float angle_rad = g_ship.angle * M_PI / 180.0f;
-        SDL_Point points[4];
-        points[0].x = (int)(g_ship.x + cosf(angle_rad) * SHIP_SIZE);
-        points[0].y = (int)(g_ship.y + sinf(angle_rad) * SHIP_SIZE);
-        points[1].x = (int)(g_ship.x + cosf(angle_rad + 2.5) * SHIP_SIZE * 0.8);
-        points[1].y = (int)(g_ship.y + sinf(angle_rad + 2.5) * SHIP_SIZE * 0.8);
-        points[2].x = (int)(g_ship.x - cosf(angle_rad) * SHIP_SIZE * 0.5f);
-        points[2].y = (int)(g_ship.y - sinf(angle_rad) * SHIP_SIZE * 0.5f);
-        points[3].x = (int)(g_ship.x + cosf(angle_rad - 2.5) * SHIP_SIZE * 0.8);
-        points[3].y = (int)(g_ship.y + sinf(angle_rad - 2.5) * SHIP_SIZE * 0.8);
-        SDL_RenderDrawLines(g_renderer, points, 4);
+    double sum = 0.0;
+    for (int t = 0; t < ticks; t++) sum += (double)samples[t];
+    double mean_ms = sum / freq * 1000.0 / ticks;
+    qsort(samples, (size_t)ticks, sizeof(Uint64), compare_u64);
+    int p99_index = (int)((long long)ticks * 99 / 100);
+    if (p99_index >= ticks) p99_index = ticks - 1;
+    double p99_ms = (double)samples[p99_index] / freq * 1000.0;
+
+    printf("headless: %d ticks in %.3f s (%.0f ticks/sec)\n", ticks, total_s, ticks / total_s);
+    printf("tick time: mean %.4f ms, p99 %.4f ms\n", mean_ms, p99_ms);
+    printf("peak entities: %d asteroids, %d bullets (%d restarts)\n",
+           peak_asteroids, peak_bullets, restarts);
+
+    // --resim M: snapshot the final (typically pathological) state and
+    // re-run the identical tick M times -- same entity layout every
+    // iteration, so run-to-run noise comes from the machine, not the game.
+    if (g_resim_ticks > 0) {
+        int m = g_resim_ticks;
+        Uint64* rs = realloc(samples, (size_t)m * sizeof(Uint64));
+        if (!rs) { free(samples); return 1; }
+        samples = rs;
+        snapshot_save();
+        Uint64 resim_start = SDL_GetPerformanceCounter();
+        for (int t = 0; t < m; t++) {
+            snapshot_restore();
+            Uint64 t0 = SDL_GetPerformanceCounter();
+            apply_ship_controls(scripted_input(ticks));
+            update_game();
+            samples[t] = SDL_GetPerformanceCounter() - t0;
+        }
+        double resim_s = (double)(SDL_GetPerformanceCounter() - resim_start) / freq;
+        sum = 0.0;
+        for (int t = 0; t < m; t++) sum += (double)samples[t];
+        qsort(samples, (size_t)m, sizeof(Uint64), compare_u64);
+        p99_index = (int)((long long)m * 99 / 100);
+        if (p99_index >= m) p99_index = m - 1;
+        printf("resim: %d runs of one tick (%d asteroids) in %.3f s\n",
+               m, g_snapshot.asteroid_count, resim_s);
+        printf("resim tick time: mean %.4f ms, p99 %.4f ms\n",
+               sum / freq * 1000.0 / m,
+               (double)samples[p99_index] / freq * 1000.0);
     }
-    
-    // Draw bullets
-    for (int i = 0; i < MAX_BULLETS; i++) {
-        if (g_bullets[i].active) {
-            SDL_RenderDrawPoint(g_renderer, (int)g_bullets[i].x, (int)g_bullets[i].y);
+    free(samples);
+    return 0;
+}
+
+// Uniform fit of the world rect into the window, centred with
+// letterbox bars when the aspect ratios differ.
+void update_render_scale() {
+    SDL_GetWindowSize(g_window, &g_window_w, &g_window_h);
+    float sx = (float)g_window_w / WORLD_WIDTH;
+    float sy = (float)g_window_h / WORLD_HEIGHT;
+    g_render_scale = sx < sy ? sx : sy;
+    g_render_off_x = (g_window_w - WORLD_WIDTH * g_render_scale) * 0.5f;
+    g_render_off_y = (g_window_h - WORLD_HEIGHT * g_render_scale) * 0.5f;
+}
+
+void batch_reserve(int extra_vertices, int extra_indices) {
+    if (g_batch_vertex_count + extra_vertices > g_batch_vertex_capacity) {
+        int cap = g_batch_vertex_capacity ? g_batch_vertex_capacity * 2 : 1024;
+        while (cap < g_batch_vertex_count + extra_vertices) cap *= 2;
+        g_batch_vertices = realloc(g_batch_vertices, cap * sizeof(SDL_Vertex));
+        g_batch_vertex_capacity = cap;
+    }
+    if (g_batch_index_count + extra_indices > g_batch_index_capacity) {
+        int cap = g_batch_index_capacity ? g_batch_index_capacity * 2 : 2048;
+        while (cap < g_batch_index_count + extra_indices) cap *= 2;
+        g_batch_indices = realloc(g_batch_indices, cap * sizeof(int));
+        g_batch_index_capacity = cap;
+    }
+}
+
+// Appends one white quad (two triangles) given its four corners in order.
+void batch_add_quad(float x0, float y0, float x1, float y1,
+                    float x2, float y2, float x3, float y3) {
+    batch_reserve(4, 6);
+    int base = g_batch_vertex_count;
+    float xs[4] = {x0, x1, x2, x3};
+    float ys[4] = {y0, y1, y2, y3};
+    for (int i = 0; i < 4; i++) {
+        SDL_Vertex* v = &g_batch_vertices[base + i];
+        v->position.x = xs[i] * g_batch_scale + g_batch_off_x;
+        v->position.y = ys[i] * g_batch_scale + g_batch_off_y;
+        v->color.r = 255; v->color.g = 255; v->color.b = 255; v->color.a = 255;
+        v->tex_coord.x = 0.0f;
+        v->tex_coord.y = 0.0f;
+    }
+    g_batch_vertex_count += 4;
+    int* idx = &g_batch_indices[g_batch_index_count];
+    idx[0] = base; idx[1] = base + 1; idx[2] = base + 2;
+    idx[3] = base; idx[4] = base + 2; idx[5] = base + 3;
+    g_batch_index_count += 6;
+}
+
+// A line segment is a quad one pixel wide along the segment normal.
+void batch_add_line(float x1, float y1, float x2, float y2) {
+    float dx = x2 - x1, dy = y2 - y1;
+    float len = sqrtf(dx * dx + dy * dy);
+    if (len < 1e-6f) { batch_add_point(x1, y1); return; }
+    float nx = -dy / len * 0.5f, ny = dx / len * 0.5f;
+    batch_add_quad(x1 + nx, y1 + ny, x2 + nx, y2 + ny,
+                   x2 - nx, y2 - ny, x1 - nx, y1 - ny);
+}
+
+void batch_add_point(float x, float y) {
+    batch_add_quad(x - 0.5f, y - 0.5f, x + 0.5f, y - 0.5f,
+                   x + 0.5f, y + 0.5f, x - 0.5f, y + 0.5f);
+}
+
+void batch_add_rect(float x, float y, float w, float h) {
+    batch_add_quad(x, y, x + w, y, x + w, y + h, x, y + h);
+}
+
+void batch_flush() {
+    if (g_batch_vertex_count > 0) {
+        SDL_RenderGeometry(g_renderer, NULL, g_batch_vertices, g_batch_vertex_count,
+                           g_batch_indices, g_batch_index_count);
+    }
+    g_batch_vertex_count = 0;
+    g_batch_index_count = 0;
+}
+
+// Serial prefix pass: every asteroid gets an exact vertex/index base in
+// the prep buffer (outline of n edges = n one-pixel quads = 4n
+// vertices, 6n indices), so workers can write disjoint compact ranges
+// with no holes and no post-join gather. Two adds per asteroid; the
+// expensive trig and transforms all happen on the pool.
+void render_prep_kick(float alpha) {
+    if (g_prep_capacity < g_asteroid_capacity) {
+        g_prep_capacity = g_asteroid_capacity;
+        for (int b = 0; b < 2; b++) {
+            g_prep_vertices[b] = realloc(g_prep_vertices[b],
+                (size_t)g_prep_capacity * SHAPE_MAX_VERTICES * 4 * sizeof(SDL_Vertex));
+            g_prep_indices[b] = realloc(g_prep_indices[b],
+                (size_t)g_prep_capacity * SHAPE_MAX_VERTICES * 6 * sizeof(int));
         }
+        g_prep_voffset = realloc(g_prep_voffset, g_prep_capacity * sizeof(int));
+        g_prep_ioffset = realloc(g_prep_ioffset, g_prep_capacity * sizeof(int));
     }
-    
-    // Draw asteroids
-    for (int i = 0; i < MAX_ASTEROIDS; i++) {
-        if (g_asteroids[i].alive) {
-            SDL_Point points[17];
-            for (int j = 0; j < g_asteroids[i].num_vertices; j++) {
-                points[j].x = (int)(g_asteroids[i].x + g_asteroids[i].vertices[j*2]);
-                points[j].y = (int)(g_asteroids[i].y + g_asteroids[i].vertices[j*2+1]);
+    g_prep_count = g_asteroid_count;
+    g_prep_alpha = alpha;
+    int v = 0, x = 0;
+    for (int i = 0; i < g_prep_count; i++) {
+        g_prep_voffset[i] = v;
+        g_prep_ioffset[i] = x;
+        if (!g_asteroid_visible[i]) continue; // culled: zero-width slot
+        int n = g_shape_num_vertices[g_asteroid_size[i]-1][g_asteroid_shape[i]];
+        n /= prep_outline_step(i, n);
+        v += n * 4;
+        x += n * 6;
+    }
+    g_prep_total_vertices = v;
+    g_prep_total_indices = x;
+    run_parallel_async(job_prep_asteroids, g_prep_count);
+}
+
+// Outline LOD decided by the governor: when shedding, small and medium
+// asteroids keep only every other model vertex. The serial prefix pass
+// and the prep workers both call this, so vertex budgets always agree.
+int prep_outline_step(int i, int n) {
+    if (g_gov_lod && g_asteroid_size[i] < 3 && n >= 8) return 2;
+    return 1;
+}
+
+// Worker body: interpolate position, refresh the rotated-vertex cache
+// if the quantized angle stepped, then emit each outline edge as a
+// one-pixel quad straight into this asteroid's buffer slot, world
+// transform applied. Same math as batch_add_line, minus the shared
+// cursor that would make it racy.
+void job_prep_asteroids(int start, int end) {
+    SDL_Vertex* verts = g_prep_vertices[g_prep_buf];
+    int* indices = g_prep_indices[g_prep_buf];
+    float alpha = g_prep_alpha;
+    for (int i = start; i < end; i++) {
+        if (!g_asteroid_visible[i]) continue; // no transform, no cache refresh
+        float ax = lerp_wrapped(g_asteroid_prev_x[i], g_asteroid_x[i], alpha, WORLD_WIDTH);
+        float ay = lerp_wrapped(g_asteroid_prev_y[i], g_asteroid_y[i], alpha, WORLD_HEIGHT);
+        const float* model = g_shape_vertices[g_asteroid_size[i]-1][g_asteroid_shape[i]];
+        int n = g_shape_num_vertices[g_asteroid_size[i]-1][g_asteroid_shape[i]];
+        int step = rot_step_for_angle(g_asteroid_angle[i]);
+        // Coarser refresh granularity under the governor: masking low
+        // bits makes the cache stay valid across several rot steps, at
+        // the price of slightly chunkier visual rotation.
+        step &= ~((1 << g_gov_rot_coarse) - 1);
+        if (step != g_asteroid_rot_step[i]) {
+            float c = g_cos_table[step], sn = g_sin_table[step];
+            for (int j = 0; j < n; j++) {
+                float vx = model[j*2];
+                float vy = model[j*2+1];
+                g_asteroid_rotated[i][j*2] = vx * c - vy * sn;
+                g_asteroid_rotated[i][j*2+1] = vx * sn + vy * c;
             }
-            points[g_asteroids[i].num_vertices] = points[0]; // Close the loop
-            SDL_RenderDrawLines(g_renderer, points, g_asteroids[i].num_vertices + 1);
+            g_asteroid_rot_step[i] = step;
         }
+        int vbase = g_prep_voffset[i];
+        int ibase = g_prep_ioffset[i];
+        // Walk the outline at the LOD stride; edge e runs from vertex
+        // e*stride to the next kept vertex, closing back to vertex 0.
+        int stride = prep_outline_step(i, n);
+        int m = n / stride;
+        for (int e = 0; e < m; e++) {
+            int j = e * stride;
+            int k = ((e + 1) % m) * stride;
+            float x1 = ax + g_asteroid_rotated[i][j*2];
+            float y1 = ay + g_asteroid_rotated[i][j*2+1];
+            float x2 = ax + g_asteroid_rotated[i][k*2];
+            float y2 = ay + g_asteroid_rotated[i][k*2+1];
+            float dx = x2 - x1, dy = y2 - y1;
+            float len = sqrtf(dx * dx + dy * dy);
+            float nx = 0.5f, ny = 0.0f;
+            if (len > 1e-6f) { nx = -dy / len * 0.5f; ny = dx / len * 0.5f; }
+            float qx[4] = {x1 + nx, x2 + nx, x2 - nx, x1 - nx};
+            float qy[4] = {y1 + ny, y2 + ny, y2 - ny, y1 - ny};
+            int base = vbase + e * 4;
+            for (int q = 0; q < 4; q++) {
+                SDL_Vertex* vtx = &verts[base + q];
+                vtx->position.x = qx[q] * g_batch_scale + g_batch_off_x;
+                vtx->position.y = qy[q] * g_batch_scale + g_batch_off_y;
+                vtx->color.r = 255; vtx->color.g = 255; vtx->color.b = 255; vtx->color.a = 255;
+                vtx->tex_coord.x = 0.0f;
+                vtx->tex_coord.y = 0.0f;
+            }
+            int* idx = &indices[ibase + e * 6];
+            idx[0] = base; idx[1] = base + 1; idx[2] = base + 2;
+            idx[3] = base; idx[4] = base + 2; idx[5] = base + 3;
+        }
+    }
+}
+
+// Joins the prep workers and submits the asteroid field as one draw
+// call, then flips the frame-parity buffer.
+void render_prep_finish() {
+    run_parallel_wait();
+    if (g_prep_total_vertices > 0) {
+        SDL_RenderGeometry(g_renderer, NULL, g_prep_vertices[g_prep_buf],
+                           g_prep_total_vertices, g_prep_indices[g_prep_buf],
+                           g_prep_total_indices);
+    }
+    g_prep_buf ^= 1;
+}
+
+// Records a bounding box drawn this frame so the next frame can erase
+// just that region. Boxes are padded for line width and rounding.
+void dirty_add(float x, float y, float w, float h) {
+    if (g_dirty_cur_count == g_dirty_capacity) {
+        int cap = g_dirty_capacity ? g_dirty_capacity * 2 : 256;
+        g_dirty_prev = realloc(g_dirty_prev, cap * sizeof(SDL_Rect));
+        g_dirty_cur = realloc(g_dirty_cur, cap * sizeof(SDL_Rect));
+        g_dirty_capacity = cap;
+    }
+    SDL_Rect* r = &g_dirty_cur[g_dirty_cur_count++];
+    r->x = (int)x - 2;
+    r->y = (int)y - 2;
+    r->w = (int)w + 4;
+    r->h = (int)h + 4;
+}
+
+// Linear interpolation between the previous and current tick positions.
+// When an entity wrapped across the torus seam this tick the two samples
+// are far apart; snap to the current position instead of streaking.
+float lerp_wrapped(float prev, float cur, float alpha, float span) {
+    float d = cur - prev;
+    if (d > span * 0.5f || d < -span * 0.5f) return cur;
+    return prev + d * alpha;
+}
+
+void render_game(float alpha) {
+    int incremental = g_incremental_mode;
+    if (incremental && !g_scene_texture) {
+        g_scene_texture = SDL_CreateTexture(g_renderer, SDL_PIXELFORMAT_RGBA8888,
+                                            SDL_TEXTUREACCESS_TARGET, WORLD_WIDTH, WORLD_HEIGHT);
+        if (!g_scene_texture) incremental = 0;
+    }
+
+    if (incremental) {
+        // Drawing lands in the world-resolution scene texture; scaling
+        // to the window happens once at the final blit.
+        g_batch_scale = 1.0f;
+        g_batch_off_x = 0.0f;
+        g_batch_off_y = 0.0f;
+        // Erase only what was drawn last frame; a full clear is cheaper
+        // once the dirty area covers most of the screen (busy scenes).
+        SDL_SetRenderTarget(g_renderer, g_scene_texture);
+        long dirty_area = 0;
+        for (int i = 0; i < g_dirty_prev_count; i++) {
+            dirty_area += (long)g_dirty_prev[i].w * g_dirty_prev[i].h;
+        }
+        SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 255);
+        if (!g_incremental_valid ||
+            dirty_area > (long)WORLD_WIDTH * WORLD_HEIGHT * g_gov_dirty_threshold_256 / 256) {
+            SDL_RenderClear(g_renderer);
+        } else {
+            SDL_RenderFillRects(g_renderer, g_dirty_prev, g_dirty_prev_count);
+        }
+        g_incremental_valid = 1;
+        g_dirty_cur_count = 0;
+        // The HUD strip changes whenever score or the profiler overlay
+        // does; cheaper to always treat it as dirty than to diff it.
+        dirty_add(0, 0, WORLD_WIDTH, 40);
+        if (g_show_profiler) dirty_add(0, WORLD_HEIGHT - 145, 160, 145);
+    } else {
+        g_batch_scale = g_render_scale;
+        g_batch_off_x = g_render_off_x;
+        g_batch_off_y = g_render_off_y;
+        SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 255);
+        SDL_RenderClear(g_renderer);
     }
+    SDL_SetRenderDrawColor(g_renderer, 255, 255, 255, 255);
+
+    // Kick the asteroid outline transform onto the worker pool; it runs
+    // while this thread draws the ship, bullets, particles and HUD.
+    render_prep_kick(alpha);
+
+    // Score, high score and lives via the cached atlas layer
+    hud_draw();
+
+
+    // Draw ships (blinking while invincible)
+    draw_ship(&g_ship, alpha, incremental);
+    if (g_net_mode) draw_ship(&g_ship2, alpha, incremental);
     
+    // Draw particles
+    for (int i = 0; i < g_particle_count; i++) {
+        float px = lerp_wrapped(g_particle_prev_x[i], g_particle_x[i], alpha, WORLD_WIDTH);
+        float py = lerp_wrapped(g_particle_prev_y[i], g_particle_y[i], alpha, WORLD_HEIGHT);
+        batch_add_point(px, py);
+        if (incremental) dirty_add(px - 1, py - 1, 2, 2);
+    }
+
+    // Draw bullets
+    for (int i = 0; i < g_bullet_count; i++) {
+        float bx = lerp_wrapped(g_bullet_prev_x[i], g_bullet_x[i], alpha, WORLD_WIDTH);
+        float by = lerp_wrapped(g_bullet_prev_y[i], g_bullet_y[i], alpha, WORLD_HEIGHT);
+        batch_add_point(bx, by);
+        if (incremental) dirty_add(bx - 1, by - 1, 2, 2);
+    }
+
+    // Asteroid dirty boxes are recorded here on the main thread (the
+    // dirty list is not thread-safe); the outlines themselves are being
+    // built by the prep workers in parallel.
+    if (incremental) {
+        for (int i = 0; i < g_asteroid_count; i++) {
+            if (!g_asteroid_visible[i]) continue;
+            float ax = lerp_wrapped(g_asteroid_prev_x[i], g_asteroid_x[i], alpha, WORLD_WIDTH);
+            float ay = lerp_wrapped(g_asteroid_prev_y[i], g_asteroid_y[i], alpha, WORLD_HEIGHT);
+            float r = g_asteroid_radius[i];
+            dirty_add(ax - r, ay - r, r * 2, r * 2);
+        }
+    }
+
+    // Profiler overlay (F1): last sample in microseconds per phase,
+    // top to bottom: integrate, collide, render, whole frame.
+    if (g_show_profiler) {
+        draw_number((int)g_prof_last_us[PROF_INTEGRATE], 10, WORLD_HEIGHT - 140);
+        draw_number((int)g_prof_last_us[PROF_COLLIDE], 10, WORLD_HEIGHT - 105);
+        draw_number((int)g_prof_last_us[PROF_RENDER], 10, WORLD_HEIGHT - 70);
+        draw_number((int)g_prof_last_us[PROF_FRAME], 10, WORLD_HEIGHT - 35);
+    }
+
+    batch_flush();
+    render_prep_finish();
+
+    if (incremental) {
+        SDL_SetRenderTarget(g_renderer, NULL);
+        SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 255);
+        SDL_RenderClear(g_renderer); // letterbox bars
+        SDL_Rect dst = {(int)g_render_off_x, (int)g_render_off_y,
+                        (int)(WORLD_WIDTH * g_render_scale), (int)(WORLD_HEIGHT * g_render_scale)};
+        SDL_RenderCopy(g_renderer, g_scene_texture, NULL, &dst);
+        // This frame's boxes become next frame's erase list
+        SDL_Rect* tmp = g_dirty_prev;
+        g_dirty_prev = g_dirty_cur;
+        g_dirty_cur = tmp;
+        g_dirty_prev_count = g_dirty_cur_count;
+    }
+
+    // The present blocks on vsync; everything after this timestamp is
+    // waiting, not work, and must not be billed to render cost or fed
+    // to the quality governor.
+    g_present_start = SDL_GetPerformanceCounter();
     SDL_RenderPresent(g_renderer);
 }
 
 void cleanup() {
+    prof_dump_csv();
+    stop_sim_workers();
+    free(g_asteroid_x); free(g_asteroid_y);
+    free(g_asteroid_prev_x); free(g_asteroid_prev_y);
+    free(g_asteroid_vx); free(g_asteroid_vy);
+    free(g_asteroid_angle); free(g_asteroid_rot_speed);
+    free(g_asteroid_size); free(g_asteroid_radius);
+    free(g_asteroid_dead); free(g_asteroid_shape);
+    free(g_asteroid_rot_step); free(g_asteroid_rotated);
+    free(g_asteroid_visible);
+    free(g_grid_next); free(g_asteroid_cell);
+    if (g_record_file) {
+        fclose(g_record_file);
+        g_record_file = NULL;
+    }
+    free(g_replay_inputs);
+    g_replay_inputs = NULL;
+    free(g_snapshot.blob);
+    g_snapshot.blob = NULL;
+#if FEATURE_NET
+    if (g_net_mode) net_shutdown();
+#endif
+    if (g_headless) return; // nothing else was initialized
+    if (g_telem_thread) {
+        queue_telemetry(1); // final session record
+        SDL_AtomicSet(&g_telem_quit, 1);
+        SDL_SemPost(g_telem_sem);
+        SDL_WaitThread(g_telem_thread, NULL);
+    }
+    if (g_telem_sem) SDL_DestroySemaphore(g_telem_sem);
+    if (g_synth_thread) SDL_WaitThread(g_synth_thread, NULL);
+    if (g_audio_thread) {
+        SDL_AtomicSet(&g_audio_quit, 1);
+        SDL_SemPost(g_sound_sem);
+        SDL_WaitThread(g_audio_thread, NULL);
+    }
+    if (g_sound_sem) SDL_DestroySemaphore(g_sound_sem);
+    for (int i = 0; i < SAMPLE_CACHE_SLOTS; i++) {
+        if (g_sample_cache[i].chunk) {
+            Mix_FreeChunk(g_sample_cache[i].chunk);
+            free(g_sample_cache[i].data);
+        }
+    }
     if(g_shoot_sound) Mix_FreeChunk(g_shoot_sound);
     if(g_thrust_sound) Mix_FreeChunk(g_thrust_sound);
     if(g_bang_large_sound) Mix_FreeChunk(g_bang_large_sound);
     if(g_bang_medium_sound) Mix_FreeChunk(g_bang_medium_sound);
     if(g_bang_small_sound) Mix_FreeChunk(g_bang_small_sound);
     Mix_CloseAudio();
+    free(g_batch_vertices);
+    free(g_batch_indices);
+    free(g_prep_vertices[0]); free(g_prep_vertices[1]);
+    free(g_prep_indices[0]); free(g_prep_indices[1]);
+    free(g_prep_voffset); free(g_prep_ioffset);
+    free(g_dirty_prev);
+    free(g_dirty_cur);
+    if (g_hud_atlas) SDL_DestroyTexture(g_hud_atlas);
+    if (g_scene_texture) SDL_DestroyTexture(g_scene_texture);
     if (g_renderer) SDL_DestroyRenderer(g_renderer);
     if (g_window) SDL_DestroyWindow(g_window);
     SDL_Quit();
 }
 
+void draw_ship(const Ship* ship, float alpha, int incremental) {
+    if (!ship->alive || (ship->invincible_timer > 0 && (ship->invincible_timer / 10) % 2 == 0))
+        return;
+    float sx = lerp_wrapped(ship->prev_x, ship->x, alpha, WORLD_WIDTH);
+    float sy = lerp_wrapped(ship->prev_y, ship->y, alpha, WORLD_HEIGHT);
+    float angle_rad = ship->angle * M_PI / 180.0f;
+    float px[4], py[4];
+    px[0] = sx + cosf(angle_rad) * SHIP_SIZE;
+    py[0] = sy + sinf(angle_rad) * SHIP_SIZE;
+    px[1] = sx + cosf(angle_rad + 2.5) * SHIP_SIZE * 0.8;
+    py[1] = sy + sinf(angle_rad + 2.5) * SHIP_SIZE * 0.8;
+    px[2] = sx - cosf(angle_rad) * SHIP_SIZE * 0.5f;
+    py[2] = sy - sinf(angle_rad) * SHIP_SIZE * 0.5f;
+    px[3] = sx + cosf(angle_rad - 2.5) * SHIP_SIZE * 0.8;
+    py[3] = sy + sinf(angle_rad - 2.5) * SHIP_SIZE * 0.8;
+    batch_add_line(px[0], py[0], px[1], py[1]);
+    batch_add_line(px[1], py[1], px[2], py[2]);
+    batch_add_line(px[2], py[2], px[3], py[3]);
+    if (incremental) dirty_add(sx - SHIP_SIZE, sy - SHIP_SIZE, SHIP_SIZE * 2, SHIP_SIZE * 2);
+}
+
+// Seven-segment truth table, shared by the immediate draw path and the
+// atlas build.
+const int g_digit_segments[10][7] = {
+    {1,1,1,0,1,1,1}, {0,0,1,0,0,1,0}, {1,0,1,1,1,0,1}, {1,0,1,1,0,1,1}, {0,1,1,1,0,1,0},
+    {1,1,0,1,0,1,1}, {1,1,0,1,1,1,1}, {1,0,1,0,0,1,0}, {1,1,1,1,1,1,1}, {1,1,1,1,0,1,1}
+};
+
 void draw_digit(int digit, int x, int y) {
-    int segments[10][7] = {
-        {1,1,1,0,1,1,1}, {0,0,1,0,0,1,0}, {1,0,1,1,1,0,1}, {1,0,1,1,0,1,1}, {0,1,1,1,0,1,0},
-        {1,1,0,1,0,1,1}, {1,1,0,1,1,1,1}, {1,0,1,0,0,1,0}, {1,1,1,1,1,1,1}, {1,1,1,1,0,1,1}
-    };
     int seg_w = 12, seg_h = 3;
     y += 5; x += 5;
-    if (segments[digit][0]) { SDL_Rect r = {x, y, seg_w, seg_h}; SDL_RenderFillRect(g_renderer, &r); }
-    if (segments[digit][1]) { SDL_Rect r = {x, y, seg_h, seg_w}; SDL_RenderFillRect(g_renderer, &r); }
-    if (segments[digit][2]) { SDL_Rect r = {x + seg_w - seg_h, y, seg_h, seg_w}; SDL_RenderFillRect(g_renderer, &r); }
-    if (segments[digit][3]) { SDL_Rect r = {x, y + seg_w - seg_h, seg_w, seg_h}; SDL_RenderFillRect(g_renderer, &r); }
-    if (segments[digit][4]) { SDL_Rect r = {x, y + seg_w, seg_h, seg_w}; SDL_RenderFillRect(g_renderer, &r); }
-    if (segments[digit][5]) { SDL_Rect r = {x + seg_w - seg_h, y + seg_w, seg_h, seg_w}; SDL_RenderFillRect(g_renderer, &r); }
-    if (segments[digit][6]) { SDL_Rect r = {x, y + 2*seg_w - seg_h, seg_w, seg_h}; SDL_RenderFillRect(g_renderer, &r); }
+    if (g_digit_segments[digit][0]) batch_add_rect(x, y, seg_w, seg_h);
+    if (g_digit_segments[digit][1]) batch_add_rect(x, y, seg_h, seg_w);
+    if (g_digit_segments[digit][2]) batch_add_rect(x + seg_w - seg_h, y, seg_h, seg_w);
+    if (g_digit_segments[digit][3]) batch_add_rect(x, y + seg_w - seg_h, seg_w, seg_h);
+    if (g_digit_segments[digit][4]) batch_add_rect(x, y + seg_w, seg_h, seg_w);
+    if (g_digit_segments[digit][5]) batch_add_rect(x + seg_w - seg_h, y + seg_w, seg_h, seg_w);
+    if (g_digit_segments[digit][6]) batch_add_rect(x, y + 2*seg_w - seg_h, seg_w, seg_h);
 }
 
 void draw_number(int number, int x, int y) {
@@ -428,3 +3126,125 @@ void draw_number(int number, int x, int y) {
         draw_digit(buffer[i] - '0', x + i * (12 + 4), y);
     }
 }
+
+// Rasterizes every glyph into the atlas exactly once, at startup.
+// Digits reuse the seven-segment table; cell 10 is the lives ship
+// outline at the same geometry the old per-frame line drawing used.
+// If texture creation fails the HUD falls back to the immediate path.
+void hud_atlas_init() {
+    g_hud_atlas = SDL_CreateTexture(g_renderer, SDL_PIXELFORMAT_RGBA8888,
+                                    SDL_TEXTUREACCESS_TARGET,
+                                    HUD_CELL_W * HUD_ATLAS_CELLS, HUD_CELL_H);
+    if (!g_hud_atlas) return;
+    SDL_SetTextureBlendMode(g_hud_atlas, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderTarget(g_renderer, g_hud_atlas);
+    SDL_SetRenderDrawBlendMode(g_renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 0);
+    SDL_RenderClear(g_renderer);
+    SDL_SetRenderDrawColor(g_renderer, 255, 255, 255, 255);
+    int seg_w = 12, seg_h = 3;
+    for (int d = 0; d < 10; d++) {
+        int x = d * HUD_CELL_W + 5, y = 5;
+        SDL_Rect segs[7] = {
+            {x, y, seg_w, seg_h},
+            {x, y, seg_h, seg_w},
+            {x + seg_w - seg_h, y, seg_h, seg_w},
+            {x, y + seg_w - seg_h, seg_w, seg_h},
+            {x, y + seg_w, seg_h, seg_w},
+            {x + seg_w - seg_h, y + seg_w, seg_h, seg_w},
+            {x, y + 2*seg_w - seg_h, seg_w, seg_h}
+        };
+        for (int s = 0; s < 7; s++) {
+            if (g_digit_segments[d][s]) SDL_RenderFillRect(g_renderer, &segs[s]);
+        }
+    }
+    int sx = HUD_GLYPH_SHIP * HUD_CELL_W;
+    SDL_Point ship[5] = {
+        {sx + 21, 10}, {sx + 1, 30}, {sx + 11, 25}, {sx + 21, 30}, {sx + 21, 10}
+    };
+    SDL_RenderDrawLines(g_renderer, ship, 5);
+    SDL_SetRenderDrawBlendMode(g_renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderTarget(g_renderer, NULL);
+    // Static index pattern; quads only ever differ in vertex data.
+    for (int q = 0; q < HUD_MAX_QUADS; q++) {
+        int* idx = &g_hud_indices[q * 6];
+        idx[0] = q * 4; idx[1] = q * 4 + 1; idx[2] = q * 4 + 2;
+        idx[3] = q * 4; idx[4] = q * 4 + 2; idx[5] = q * 4 + 3;
+    }
+}
+
+// Appends one atlas-cell quad at world position (x, y), applying the
+// same batch transform as batch_add_quad.
+void hud_add_glyph(int cell, float x, float y) {
+    if (g_hud_quads >= HUD_MAX_QUADS) return;
+    float u0 = (float)(cell * HUD_CELL_W) / (HUD_CELL_W * HUD_ATLAS_CELLS);
+    float u1 = (float)((cell + 1) * HUD_CELL_W) / (HUD_CELL_W * HUD_ATLAS_CELLS);
+    float xs[4] = {x, x + HUD_CELL_W, x + HUD_CELL_W, x};
+    float ys[4] = {y, y, y + HUD_CELL_H, y + HUD_CELL_H};
+    float us[4] = {u0, u1, u1, u0};
+    float vs[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+    SDL_Vertex* v = &g_hud_vertices[g_hud_quads * 4];
+    for (int i = 0; i < 4; i++) {
+        v[i].position.x = xs[i] * g_batch_scale + g_batch_off_x;
+        v[i].position.y = ys[i] * g_batch_scale + g_batch_off_y;
+        v[i].color.r = 255; v[i].color.g = 255; v[i].color.b = 255; v[i].color.a = 255;
+        v[i].tex_coord.x = us[i];
+        v[i].tex_coord.y = vs[i];
+    }
+    g_hud_quads++;
+}
+
+// Same layout rules as draw_number: 16 px advance, glyph interior
+// already carries the (5,5) offset inside its cell.
+void hud_add_number(int number, float x, float y) {
+    if (number == 0) {
+        hud_add_glyph(0, x, y);
+        return;
+    }
+    char buffer[12];
+    sprintf(buffer, "%d", number);
+    for (int i = 0; buffer[i] != '\0'; i++) {
+        hud_add_glyph(buffer[i] - '0', x + i * (12 + 4), y);
+    }
+}
+
+// Score, high score and lives in one textured draw call. The quad
+// batch is recomposed only when a value or the batch transform (window
+// resize, incremental toggle) changed since last frame.
+void hud_draw() {
+    if (!g_hud_atlas) {
+        draw_number(g_score, 10, 5);
+        draw_number(g_high_score, WORLD_WIDTH / 2 - 40, 5);
+        for (int i = 0; i < g_lives; i++) {
+            float lx = (float)(WORLD_WIDTH - 30 - i*30);
+            batch_add_line(lx, 10, lx - 20, 30);
+            batch_add_line(lx - 20, 30, lx - 10, 25);
+            batch_add_line(lx - 10, 25, lx, 30);
+            batch_add_line(lx, 30, lx, 10);
+        }
+        return;
+    }
+    if (g_score != g_hud_score || g_high_score != g_hud_high || g_lives != g_hud_lives ||
+        g_batch_scale != g_hud_scale || g_batch_off_x != g_hud_off_x ||
+        g_batch_off_y != g_hud_off_y) {
+        g_hud_quads = 0;
+        hud_add_number(g_score, 10, 5);
+        hud_add_number(g_high_score, WORLD_WIDTH / 2 - 40, 5);
+        // The ship glyph's right edge sits at local x 21 in its cell;
+        // line the quad up so that edge lands where the old immediate
+        // drawing put it.
+        for (int i = 0; i < g_lives; i++) {
+            hud_add_glyph(HUD_GLYPH_SHIP, (float)(WORLD_WIDTH - 30 - i*30 - 21), 0.0f);
+        }
+        g_hud_score = g_score;
+        g_hud_high = g_high_score;
+        g_hud_lives = g_lives;
+        g_hud_scale = g_batch_scale;
+        g_hud_off_x = g_batch_off_x;
+        g_hud_off_y = g_batch_off_y;
+    }
+    if (g_hud_quads > 0) {
+        SDL_RenderGeometry(g_renderer, g_hud_atlas, g_hud_vertices, g_hud_quads * 4,
+                           g_hud_indices, g_hud_quads * 6);
+    }
+}